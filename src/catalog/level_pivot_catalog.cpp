@@ -90,7 +90,7 @@ DatabaseSize LevelPivotCatalog::GetDatabaseSize(ClientContext &context) {
 	size.used_blocks = 0;
 	size.wal_size = 0;
 	size.block_size = 0;
-	size.bytes = 0;
+	size.bytes = connection_->approximate_size("", "");
 	return size;
 }
 
@@ -104,9 +104,17 @@ string LevelPivotCatalog::GetDBPath() {
 
 void LevelPivotCatalog::CreatePivotTable(const string &table_name, const string &pattern,
                                          const vector<string> &column_names, const vector<LogicalType> &column_types,
-                                         const vector<bool> &column_json) {
-	// Parse the key pattern
-	auto key_pattern = std::make_unique<level_pivot::KeyPattern>(pattern);
+                                         const vector<LevelPivotValueEncoding> &column_encodings,
+                                         LevelPivotTableMode mode, bool attr_codes) {
+	// Parse the key pattern. A packed key holds a whole row, so its pattern has captures but no {attr}.
+	auto packed = mode == LevelPivotTableMode::PACKED;
+	auto key_pattern = std::make_unique<level_pivot::KeyPattern>(pattern, !packed);
+	if (packed && key_pattern->has_attr()) {
+		throw InvalidInputException("Packed table pattern '%s' cannot contain {attr}", pattern);
+	}
+	if (packed && key_pattern->capture_count() == 0) {
+		throw InvalidInputException("Packed table pattern '%s' must contain at least one capture", pattern);
+	}
 	auto key_parser = std::make_unique<level_pivot::KeyParser>(*key_pattern);
 
 	// Separate identity columns from attr columns
@@ -124,8 +132,9 @@ void LevelPivotCatalog::CreatePivotTable(const string &table_name, const string
 			}
 		}
 		if (is_identity) {
-			if (column_json[i]) {
-				throw InvalidInputException("Identity column '%s' cannot be JSON-encoded", col_name);
+			if (column_encodings[i] != LevelPivotValueEncoding::TEXT) {
+				throw InvalidInputException("Identity column '%s' cannot be %s-encoded", col_name,
+				                            ValueEncodingName(column_encodings[i]));
 			}
 			identity_columns.push_back(col_name);
 		} else {
@@ -142,17 +151,21 @@ void LevelPivotCatalog::CreatePivotTable(const string &table_name, const string
 	}
 
 	auto table_entry = make_uniq<LevelPivotTableEntry>(*this, *main_schema_, *info, connection_, std::move(key_parser),
-	                                                   identity_columns, attr_columns, vector<bool>(column_json));
+	                                                   identity_columns, attr_columns, column_encodings, mode);
+	if (attr_codes) {
+		table_entry->InternAttrNames();
+	}
 	main_schema_->AddTable(std::move(table_entry));
 }
 
 void LevelPivotCatalog::CreateRawTable(const string &table_name, const vector<string> &column_names,
-                                       const vector<LogicalType> &column_types, const vector<bool> &column_json) {
+                                       const vector<LogicalType> &column_types,
+                                       const vector<LevelPivotValueEncoding> &column_encodings) {
 	if (column_names.size() != 2) {
 		throw InvalidInputException("Raw tables must have exactly 2 columns (key, value)");
 	}
-	if (column_json[0]) {
-		throw InvalidInputException("Key column cannot be JSON-encoded");
+	if (column_encodings[0] != LevelPivotValueEncoding::TEXT) {
+		throw InvalidInputException("Key column cannot be %s-encoded", ValueEncodingName(column_encodings[0]));
 	}
 
 	auto info = make_uniq<CreateTableInfo>();
@@ -163,11 +176,15 @@ void LevelPivotCatalog::CreateRawTable(const string &table_name, const vector<st
 	}
 
 	auto table_entry =
-	    make_uniq<LevelPivotTableEntry>(*this, *main_schema_, *info, connection_, vector<bool>(column_json));
+	    make_uniq<LevelPivotTableEntry>(*this, *main_schema_, *info, connection_, column_encodings);
 	main_schema_->AddTable(std::move(table_entry));
 }
 
 void LevelPivotCatalog::DropTable(const string &table_name) {
+	auto table = main_schema_->GetTable(table_name);
+	if (table) {
+		table->InvalidateStatistics();
+	}
 	main_schema_->DropTable(table_name);
 }
 
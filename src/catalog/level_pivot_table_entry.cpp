@@ -1,32 +1,47 @@
 #include "level_pivot_table_entry.hpp"
 #include "level_pivot_scan.hpp"
+#include "level_pivot_transaction.hpp"
+#include "level_pivot_utils.hpp"
 #include "duckdb/storage/table_storage_info.hpp"
 #include "duckdb/parser/parsed_data/create_table_info.hpp"
 #include "duckdb/common/table_column.hpp"
+#include "duckdb/storage/statistics/base_statistics.hpp"
+#include "duckdb/storage/statistics/numeric_stats.hpp"
+#include "duckdb/storage/statistics/string_stats.hpp"
+#include <algorithm>
 
 namespace duckdb {
 
-// Pivot mode constructor
+// Keys read from the start of a range to measure rows per byte
+static constexpr idx_t ESTIMATE_SAMPLE_KEYS = 1024;
+
+// Pivot and packed mode constructor
 LevelPivotTableEntry::LevelPivotTableEntry(Catalog &catalog, SchemaCatalogEntry &schema, CreateTableInfo &info,
                                            std::shared_ptr<level_pivot::LevelDBConnection> connection,
                                            std::unique_ptr<level_pivot::KeyParser> parser,
                                            vector<string> identity_columns, vector<string> attr_columns,
-                                           vector<bool> column_json)
-    : TableCatalogEntry(catalog, schema, info), mode_(LevelPivotTableMode::PIVOT), connection_(std::move(connection)),
+                                           vector<LevelPivotValueEncoding> column_encodings, LevelPivotTableMode mode)
+    : TableCatalogEntry(catalog, schema, info), mode_(mode), connection_(std::move(connection)),
       parser_(std::move(parser)), identity_columns_(std::move(identity_columns)),
-      attr_columns_(std::move(attr_columns)), column_json_(std::move(column_json)) {
+      attr_columns_(std::move(attr_columns)), attr_keys_(attr_columns_),
+      column_encodings_(std::move(column_encodings)) {
+	auto &pattern = parser_->pattern();
+	for (auto &id_col : identity_columns_) {
+		identity_encodings_.push_back(pattern.capture_encoding(pattern.capture_index(id_col)));
+	}
 	BuildColumnIndexCache();
 }
 
 // Raw mode constructor
 LevelPivotTableEntry::LevelPivotTableEntry(Catalog &catalog, SchemaCatalogEntry &schema, CreateTableInfo &info,
                                            std::shared_ptr<level_pivot::LevelDBConnection> connection,
-                                           vector<bool> column_json)
+                                           vector<LevelPivotValueEncoding> column_encodings)
     : TableCatalogEntry(catalog, schema, info), mode_(LevelPivotTableMode::RAW), connection_(std::move(connection)),
-      column_json_(std::move(column_json)) {
+      column_encodings_(std::move(column_encodings)) {
 	// For raw mode: column 0 = key, column 1 = value
 	if (info.columns.LogicalColumnCount() >= 1) {
 		identity_columns_.push_back(info.columns.GetColumn(LogicalIndex(0)).Name());
+		identity_encodings_.push_back(level_pivot::CaptureEncoding::TEXT);
 	}
 	BuildColumnIndexCache();
 }
@@ -45,6 +60,153 @@ idx_t LevelPivotTableEntry::GetColumnIndex(const string &col_name) const {
 	throw InternalException("Column '%s' not found in table '%s'", col_name, name);
 }
 
+const string &LevelPivotTableEntry::GetAttrKey(const string &attr_name) const {
+	auto it = std::find(attr_columns_.begin(), attr_columns_.end(), attr_name);
+	if (it == attr_columns_.end()) {
+		throw InternalException("Column '%s' is not an attr column of table '%s'", attr_name, name);
+	}
+	return attr_keys_[it - attr_columns_.begin()];
+}
+
+void LevelPivotTableEntry::InitializeAttrDispatch(AttrDispatch &dispatch,
+                                                  const vector<std::string_view> &attr_keys) const {
+	if (attr_codec_) {
+		dispatch.InitializeCodes(*attr_codec_, attr_keys);
+	} else {
+		dispatch.Initialize(attr_keys);
+	}
+}
+
+string LevelPivotTableEntry::GetAttrCodesKey(const string &pattern) {
+	return string(METADATA_KEY_PREFIX) + "attr_codes##" + pattern;
+}
+
+// Stored as a JSON array of attr names, indexed by code. Codes are only ever appended, so keys written by an
+// earlier definition of the table keep their meaning.
+void LevelPivotTableEntry::InternAttrNames() {
+	auto &pattern = parser_->pattern().pattern();
+	attr_codec_ = std::make_unique<level_pivot::AttrCodec>(parser_->pattern());
+	auto codes_key = GetAttrCodesKey(pattern);
+
+	vector<string> code_names;
+	auto json = connection_->get(codes_key);
+	if (json) {
+		auto *doc =
+		    duckdb_yyjson::yyjson_read(json->data(), json->size(), duckdb_yyjson::YYJSON_READ_ALLOW_INVALID_UNICODE);
+		auto *root = doc ? duckdb_yyjson::yyjson_doc_get_root(doc) : nullptr;
+		bool valid = duckdb_yyjson::yyjson_is_arr(root);
+		for (idx_t i = 0; valid && i < duckdb_yyjson::yyjson_arr_size(root); i++) {
+			auto *val = duckdb_yyjson::yyjson_arr_get(root, i);
+			valid = duckdb_yyjson::yyjson_is_str(val);
+			if (valid) {
+				code_names.emplace_back(duckdb_yyjson::yyjson_get_str(val), duckdb_yyjson::yyjson_get_len(val));
+			}
+		}
+		if (doc) {
+			duckdb_yyjson::yyjson_doc_free(doc);
+		}
+		if (!valid) {
+			throw IOException("Attr codes stored for pattern '%s' are corrupt", pattern);
+		}
+	}
+
+	bool assigned = false;
+	for (idx_t a = 0; a < attr_columns_.size(); a++) {
+		auto it = std::find(code_names.begin(), code_names.end(), attr_columns_[a]);
+		if (it == code_names.end()) {
+			if (code_names.size() >= attr_codec_->capacity()) {
+				throw InvalidInputException("Too many attr codes for pattern '%s'", pattern);
+			}
+			code_names.push_back(attr_columns_[a]);
+			it = code_names.end() - 1;
+			assigned = true;
+		}
+		attr_keys_[a] = attr_codec_->encode(static_cast<uint32_t>(it - code_names.begin()));
+	}
+	// Read-only databases can't hold data under new codes, so those only live for this session
+	if (!assigned || connection_->is_read_only()) {
+		return;
+	}
+
+	auto *doc = duckdb_yyjson::yyjson_mut_doc_new(nullptr);
+	auto *root = duckdb_yyjson::yyjson_mut_arr(doc);
+	duckdb_yyjson::yyjson_mut_doc_set_root(doc, root);
+	for (auto &code_name : code_names) {
+		duckdb_yyjson::yyjson_mut_arr_add_strncpy(doc, root, code_name.data(), code_name.size());
+	}
+	size_t json_len = 0;
+	char *json_str = duckdb_yyjson::yyjson_mut_write(doc, duckdb_yyjson::YYJSON_WRITE_ALLOW_INVALID_UNICODE, &json_len);
+	duckdb_yyjson::yyjson_mut_doc_free(doc);
+	if (!json_str) {
+		throw IOException("Failed to serialize attr codes for pattern '%s'", pattern);
+	}
+	connection_->put(codes_key, std::string_view(json_str, json_len));
+	free(json_str);
+}
+
+string LevelPivotTableEntry::GetKeyPrefix() const {
+	return HasKeyPattern() ? parser_->build_prefix() : string();
+}
+
+LevelPivotRangeEstimate LevelPivotTableEntry::EstimateRange(const string &start, const string &end) {
+	LevelPivotRangeEstimate result;
+	result.bytes = connection_->approximate_size(start, end);
+
+	// Count rows and raw bytes in a sample from the start of the range
+	auto iter = connection_->iterator();
+	if (start.empty()) {
+		iter.seek_to_first();
+	} else {
+		iter.seek(start);
+	}
+	std::string_view captures[level_pivot::MAX_KEY_CAPTURES];
+	std::string_view attr;
+	string identity;
+	string previous_identity;
+	idx_t sample_keys = 0;
+	idx_t sample_rows = 0;
+	uint64_t sample_bytes = 0;
+	while (iter.valid() && IsBeforeEnd(iter.key_view(), end) && sample_keys < ESTIMATE_SAMPLE_KEYS) {
+		auto key = iter.key_view();
+		sample_keys++;
+		sample_bytes += key.size() + iter.value_view().size();
+		if (mode_ == LevelPivotTableMode::PIVOT) {
+			if (parser_->parse_fast(key, captures, attr)) {
+				identity.clear();
+				for (size_t i = 0; i < parser_->pattern().capture_count(); i++) {
+					identity.append(captures[i].data(), captures[i].size());
+					identity.push_back('\0');
+				}
+				if (sample_rows == 0 || identity != previous_identity) {
+					sample_rows++;
+					std::swap(identity, previous_identity);
+				}
+			}
+		} else {
+			sample_rows++;
+		}
+		iter.next();
+	}
+
+	if (!iter.valid() || !IsBeforeEnd(iter.key_view(), end)) {
+		result.rows = sample_rows;
+		result.exact = true;
+		return result;
+	}
+	if (sample_rows == 0) {
+		return result;
+	}
+
+	// Extrapolate rows-per-byte from the sample. Prefer the sample's on-disk size so compression cancels
+	// out; fall back to raw bytes when the sample is too small to register (or still in the memtable).
+	auto sample_disk_bytes = connection_->approximate_size(start, iter.key_view());
+	double bytes_per_row = static_cast<double>(sample_disk_bytes > 0 ? sample_disk_bytes : sample_bytes) /
+	                       static_cast<double>(sample_rows);
+	auto extrapolated = static_cast<idx_t>(static_cast<double>(result.bytes) / bytes_per_row);
+	result.rows = MaxValue<idx_t>(sample_rows, extrapolated);
+	return result;
+}
+
 TableFunction LevelPivotTableEntry::GetScanFunction(ClientContext &context, unique_ptr<FunctionData> &bind_data) {
 	auto data = make_uniq<LevelPivotScanData>();
 	data->table_entry = this;
@@ -52,19 +214,211 @@ TableFunction LevelPivotTableEntry::GetScanFunction(ClientContext &context, uniq
 	return LevelPivotScanFunction();
 }
 
+string LevelPivotTableEntry::GetStatisticsKey(const string &table_name) {
+	return string(METADATA_KEY_PREFIX) + "stats##" + table_name;
+}
+
+// Min/max are only kept for types whose statistics DuckDB can prune with
+static bool HasBoundStatistics(const LogicalType &type) {
+	auto stats_type = BaseStatistics::GetStatsType(type);
+	return stats_type == StatisticsType::NUMERIC_STATS || stats_type == StatisticsType::STRING_STATS;
+}
+
+// Stored as {"pattern": ..., "columns": [{"name", "type", "min", "max", "nulls", "non_nulls", "distinct"}, ...]}.
+// The pattern and column names/types are checked on load so statistics never apply to a redefined table.
+string LevelPivotTableEntry::SerializeStatistics(const vector<LevelPivotColumnStats> &stats) const {
+	auto *doc = duckdb_yyjson::yyjson_mut_doc_new(nullptr);
+	auto *root = duckdb_yyjson::yyjson_mut_obj(doc);
+	duckdb_yyjson::yyjson_mut_doc_set_root(doc, root);
+
+	auto pattern = HasKeyPattern() ? parser_->pattern().pattern() : string();
+	duckdb_yyjson::yyjson_mut_obj_add_strncpy(doc, root, "pattern", pattern.data(), pattern.size());
+	auto *columns = duckdb_yyjson::yyjson_mut_obj_add_arr(doc, root, "columns");
+	for (idx_t i = 0; i < stats.size(); i++) {
+		auto &col = GetColumns().GetColumn(LogicalIndex(i));
+		auto type_str = col.Type().ToString();
+		auto *obj = duckdb_yyjson::yyjson_mut_arr_add_obj(doc, columns);
+		duckdb_yyjson::yyjson_mut_obj_add_strncpy(doc, obj, "name", col.Name().data(), col.Name().size());
+		duckdb_yyjson::yyjson_mut_obj_add_strncpy(doc, obj, "type", type_str.data(), type_str.size());
+		if (!stats[i].min.IsNull() && !stats[i].max.IsNull()) {
+			auto min_str = stats[i].min.ToString();
+			auto max_str = stats[i].max.ToString();
+			duckdb_yyjson::yyjson_mut_obj_add_strncpy(doc, obj, "min", min_str.data(), min_str.size());
+			duckdb_yyjson::yyjson_mut_obj_add_strncpy(doc, obj, "max", max_str.data(), max_str.size());
+		}
+		duckdb_yyjson::yyjson_mut_obj_add_uint(doc, obj, "nulls", stats[i].null_count);
+		duckdb_yyjson::yyjson_mut_obj_add_uint(doc, obj, "non_nulls", stats[i].non_null_count);
+		duckdb_yyjson::yyjson_mut_obj_add_uint(doc, obj, "distinct", stats[i].distinct_count);
+	}
+
+	size_t json_len = 0;
+	char *json_str = duckdb_yyjson::yyjson_mut_write(doc, duckdb_yyjson::YYJSON_WRITE_ALLOW_INVALID_UNICODE, &json_len);
+	duckdb_yyjson::yyjson_mut_doc_free(doc);
+	if (!json_str) {
+		throw IOException("Failed to serialize statistics for table '%s'", name);
+	}
+	string result(json_str, json_len);
+	free(json_str);
+	return result;
+}
+
+static bool JsonStringEquals(duckdb_yyjson::yyjson_val *val, const string &expected) {
+	return duckdb_yyjson::yyjson_is_str(val) &&
+	       string(duckdb_yyjson::yyjson_get_str(val), duckdb_yyjson::yyjson_get_len(val)) == expected;
+}
+
+bool LevelPivotTableEntry::DeserializeStatistics(std::string_view json, vector<LevelPivotColumnStats> &stats) const {
+	auto *doc = duckdb_yyjson::yyjson_read(json.data(), json.size(), duckdb_yyjson::YYJSON_READ_ALLOW_INVALID_UNICODE);
+	if (!doc) {
+		return false;
+	}
+	auto *root = duckdb_yyjson::yyjson_doc_get_root(doc);
+	auto pattern = HasKeyPattern() ? parser_->pattern().pattern() : string();
+	auto *columns = duckdb_yyjson::yyjson_obj_get(root, "columns");
+	bool valid = JsonStringEquals(duckdb_yyjson::yyjson_obj_get(root, "pattern"), pattern) &&
+	             duckdb_yyjson::yyjson_is_arr(columns) &&
+	             duckdb_yyjson::yyjson_arr_size(columns) == GetColumns().LogicalColumnCount();
+	stats.clear();
+	for (idx_t i = 0; valid && i < GetColumns().LogicalColumnCount(); i++) {
+		auto &col = GetColumns().GetColumn(LogicalIndex(i));
+		auto *obj = duckdb_yyjson::yyjson_arr_get(columns, i);
+		if (!JsonStringEquals(duckdb_yyjson::yyjson_obj_get(obj, "name"), col.Name()) ||
+		    !JsonStringEquals(duckdb_yyjson::yyjson_obj_get(obj, "type"), col.Type().ToString())) {
+			valid = false;
+			break;
+		}
+		LevelPivotColumnStats col_stats;
+		col_stats.null_count = duckdb_yyjson::yyjson_get_uint(duckdb_yyjson::yyjson_obj_get(obj, "nulls"));
+		col_stats.non_null_count = duckdb_yyjson::yyjson_get_uint(duckdb_yyjson::yyjson_obj_get(obj, "non_nulls"));
+		col_stats.distinct_count = duckdb_yyjson::yyjson_get_uint(duckdb_yyjson::yyjson_obj_get(obj, "distinct"));
+		auto *min_val = duckdb_yyjson::yyjson_obj_get(obj, "min");
+		auto *max_val = duckdb_yyjson::yyjson_obj_get(obj, "max");
+		if (duckdb_yyjson::yyjson_is_str(min_val) && duckdb_yyjson::yyjson_is_str(max_val)) {
+			try {
+				col_stats.min = StringToTypedValue(
+				    std::string_view(duckdb_yyjson::yyjson_get_str(min_val), duckdb_yyjson::yyjson_get_len(min_val)),
+				    col.Type());
+				col_stats.max = StringToTypedValue(
+				    std::string_view(duckdb_yyjson::yyjson_get_str(max_val), duckdb_yyjson::yyjson_get_len(max_val)),
+				    col.Type());
+			} catch (std::exception &) {
+				valid = false;
+				break;
+			}
+		}
+		stats.push_back(std::move(col_stats));
+	}
+	duckdb_yyjson::yyjson_doc_free(doc);
+	if (!valid) {
+		stats.clear();
+	}
+	return valid;
+}
+
+// Caller must hold stats_lock_
+void LevelPivotTableEntry::LoadStatistics() {
+	if (stats_loaded_) {
+		return;
+	}
+	stats_loaded_ = true;
+	auto json = connection_->get(GetStatisticsKey(name));
+	if (json) {
+		DeserializeStatistics(*json, stats_);
+	}
+}
+
+idx_t LevelPivotTableEntry::GetStatisticsVersion() {
+	lock_guard<mutex> guard(stats_lock_);
+	return stats_version_;
+}
+
+bool LevelPivotTableEntry::SetAnalyzedStatistics(vector<LevelPivotColumnStats> stats, idx_t version) {
+	lock_guard<mutex> guard(stats_lock_);
+	if (version != stats_version_) {
+		// A commit wrote the table while it was being analyzed, so the statistics may not cover its rows (or another
+		// analyze finished first)
+		return false;
+	}
+	stats_version_++;
+	// Read-only databases keep the statistics for this session only
+	if (!connection_->is_read_only()) {
+		connection_->put(GetStatisticsKey(name), SerializeStatistics(stats));
+	}
+	stats_ = std::move(stats);
+	stats_loaded_ = true;
+	return true;
+}
+
+void LevelPivotTableEntry::InvalidateStatistics(idx_t deleted_at_version) {
+	lock_guard<mutex> guard(stats_lock_);
+	bool stored_deleted = deleted_at_version == stats_version_;
+	stats_version_++;
+	if (stored_deleted) {
+		stats_.clear();
+		stats_loaded_ = true;
+		return;
+	}
+	LoadStatistics();
+	if (stats_.empty()) {
+		return;
+	}
+	stats_.clear();
+	if (!connection_->is_read_only()) {
+		connection_->del(GetStatisticsKey(name));
+	}
+}
+
 unique_ptr<BaseStatistics> LevelPivotTableEntry::GetStatistics(ClientContext &context, column_t column_id) {
-	return nullptr;
+	// The statistics describe committed data, which a transaction that wrote the table no longer sees
+	if (LevelPivotTransaction::Get(context, ParentCatalog()).GetDirtyTables().count(name)) {
+		return nullptr;
+	}
+	lock_guard<mutex> guard(stats_lock_);
+	LoadStatistics();
+	if (column_id >= stats_.size()) {
+		return nullptr;
+	}
+	auto &col_stats = stats_[column_id];
+	auto &type = GetColumns().GetColumn(LogicalIndex(column_id)).Type();
+
+	bool has_bounds = !col_stats.min.IsNull() && !col_stats.max.IsNull();
+	bool use_bounds = HasBoundStatistics(type) && (has_bounds || col_stats.non_null_count == 0);
+	auto result = use_bounds ? BaseStatistics::CreateEmpty(type) : BaseStatistics::CreateUnknown(type);
+	if (use_bounds) {
+		if (col_stats.null_count > 0) {
+			result.SetHasNull();
+		}
+		if (col_stats.non_null_count > 0) {
+			result.SetHasNoNull();
+		}
+		if (has_bounds && BaseStatistics::GetStatsType(type) == StatisticsType::NUMERIC_STATS) {
+			NumericStats::SetMin(result, col_stats.min);
+			NumericStats::SetMax(result, col_stats.max);
+		} else if (has_bounds) {
+			auto min_str = StringValue::Get(col_stats.min);
+			auto max_str = StringValue::Get(col_stats.max);
+			StringStats::Update(result, string_t(min_str.data(), static_cast<uint32_t>(min_str.size())));
+			StringStats::Update(result, string_t(max_str.data(), static_cast<uint32_t>(max_str.size())));
+			// Only min/max were kept - don't let DuckDB rely on the length or ASCII-ness of two samples
+			StringStats::ResetMaxStringLength(result);
+			StringStats::SetContainsUnicode(result);
+		}
+	}
+	result.SetDistinctCount(col_stats.distinct_count);
+	return result.ToUnique();
 }
 
 TableStorageInfo LevelPivotTableEntry::GetStorageInfo(ClientContext &context) {
 	TableStorageInfo result;
-	result.cardinality = 0;
+	auto prefix = GetKeyPrefix();
+	// The few metadata keys a range may include are noise in the estimate
+	result.cardinality = EstimateRange(prefix, PrefixSuccessor(prefix)).rows;
 	return result;
 }
 
 vector<column_t> LevelPivotTableEntry::GetRowIdColumns() const {
 	vector<column_t> result;
-	if (mode_ == LevelPivotTableMode::PIVOT) {
+	if (HasKeyPattern()) {
 		// Return identity column indices as row identifiers
 		for (auto &id_col : identity_columns_) {
 			auto it = col_name_to_index_.find(id_col);
@@ -84,7 +438,7 @@ virtual_column_map_t LevelPivotTableEntry::GetVirtualColumns() const {
 	// Add the standard rowid virtual column
 	result.insert(make_pair(COLUMN_IDENTIFIER_ROW_ID, TableColumn("rowid", LogicalType::ROW_TYPE)));
 	// Add identity columns as virtual columns so BindRowIdColumns can find them
-	if (mode_ == LevelPivotTableMode::PIVOT) {
+	if (HasKeyPattern()) {
 		for (auto &id_col : identity_columns_) {
 			auto it = col_name_to_index_.find(id_col);
 			if (it != col_name_to_index_.end()) {
@@ -5,12 +5,12 @@ namespace level_pivot {
 
 KeyParser::KeyParser(const KeyPattern &pattern) : pattern_(pattern) {
 	compute_estimated_key_size();
-	try_init_simd_parser();
+	init_parser();
 }
 
 KeyParser::KeyParser(const std::string &pattern) : pattern_(pattern) {
 	compute_estimated_key_size();
-	try_init_simd_parser();
+	init_parser();
 }
 
 void KeyParser::compute_estimated_key_size() {
@@ -25,120 +25,31 @@ void KeyParser::compute_estimated_key_size() {
 	}
 }
 
-namespace {
-
-template <typename ResultType>
-struct ParsePolicy;
-
-template <>
-struct ParsePolicy<ParsedKeyView> {
-	static void add_capture(ParsedKeyView &result, std::string_view key, size_t pos, size_t len) {
-		result.capture_values.push_back(key.substr(pos, len));
-	}
-	static void set_attr(ParsedKeyView &result, std::string_view key, size_t pos, size_t len) {
-		result.attr_name = key.substr(pos, len);
-	}
-};
-
-template <typename ResultType>
-std::optional<ResultType> parse_impl(const KeyPattern &pattern, std::string_view key) {
-	const auto &segments = pattern.segments();
-	ResultType result;
-	result.capture_values.reserve(pattern.capture_count());
-
-	size_t key_pos = 0;
-
-	for (size_t seg_idx = 0; seg_idx < segments.size(); ++seg_idx) {
-		const auto &segment = segments[seg_idx];
-
-		if (std::holds_alternative<LiteralSegment>(segment)) {
-			const auto &literal = std::get<LiteralSegment>(segment);
-			if (key.compare(key_pos, literal.text.size(), literal.text) != 0) {
-				return std::nullopt;
-			}
-			key_pos += literal.text.size();
-
-		} else if (std::holds_alternative<CaptureSegment>(segment)) {
-			size_t end_pos;
-			if (seg_idx + 1 < segments.size()) {
-				const auto &next_literal = std::get<LiteralSegment>(segments[seg_idx + 1]);
-				end_pos = key.find(next_literal.text, key_pos);
-				if (end_pos == std::string_view::npos) {
-					return std::nullopt;
-				}
-			} else {
-				end_pos = key.size();
-			}
-
-			if (end_pos == key_pos) {
-				return std::nullopt;
-			}
-
-			ParsePolicy<ResultType>::add_capture(result, key, key_pos, end_pos - key_pos);
-			key_pos = end_pos;
-
-		} else if (std::holds_alternative<AttrSegment>(segment)) {
-			size_t end_pos;
-			if (seg_idx + 1 < segments.size()) {
-				const auto &next_literal = std::get<LiteralSegment>(segments[seg_idx + 1]);
-				end_pos = key.find(next_literal.text, key_pos);
-				if (end_pos == std::string_view::npos) {
-					return std::nullopt;
-				}
-			} else {
-				end_pos = key.size();
-			}
-
-			if (end_pos == key_pos) {
-				return std::nullopt;
-			}
-
-			ParsePolicy<ResultType>::set_attr(result, key, key_pos, end_pos - key_pos);
-			key_pos = end_pos;
-		}
-	}
-
-	if (key_pos != key.size()) {
+std::optional<ParsedKeyView> KeyParser::parse_view(std::string_view key) const {
+	std::string_view captures[MAX_KEY_CAPTURES];
+	std::string_view attr;
+	if (!parse_fast(key, captures, attr)) {
 		return std::nullopt;
 	}
-
+	ParsedKeyView result;
+	result.capture_values.reserve(pattern_.capture_count());
+	for (size_t i = 0; i < pattern_.capture_count(); ++i) {
+		result.capture_values.push_back(captures[i]);
+	}
+	result.attr_name = attr;
 	return result;
 }
 
-} // anonymous namespace
-
-std::optional<ParsedKeyView> KeyParser::parse_view(std::string_view key) const {
-	if (simd_parser_) {
-		std::string_view captures[MAX_KEY_CAPTURES];
-		std::string_view attr;
-		if (simd_parser_->parse_fast(key, captures, attr)) {
-			ParsedKeyView result;
-			result.capture_values.reserve(pattern_.capture_count());
-			for (size_t i = 0; i < pattern_.capture_count(); ++i) {
-				result.capture_values.push_back(captures[i]);
-			}
-			result.attr_name = attr;
-			return result;
-		}
-		return std::nullopt;
-	}
-	return parse_impl<ParsedKeyView>(pattern_, key);
+bool KeyParser::parse_fast(std::string_view key, std::string_view *captures, std::string_view &attr) const {
+	bool result = false;
+	visit([&](const auto &parser) { result = parser.parse_fast(key, captures, attr); });
+	return result;
 }
 
-bool KeyParser::parse_fast(std::string_view key, std::string_view *captures, std::string_view &attr) const {
-	if (simd_parser_) {
-		return simd_parser_->parse_fast(key, captures, attr);
-	}
-	// Fallback: use generic parse_impl and copy results
-	auto result = parse_impl<ParsedKeyView>(pattern_, key);
-	if (!result) {
-		return false;
-	}
-	for (size_t i = 0; i < result->capture_values.size(); ++i) {
-		captures[i] = result->capture_values[i];
-	}
-	attr = result->attr_name;
-	return true;
+bool KeyParser::parse_attr(std::string_view key, size_t identity_len, std::string_view &attr) const {
+	bool result = false;
+	visit([&](const auto &parser) { result = parser.parse_attr(key, identity_len, attr); });
+	return result;
 }
 
 std::string KeyParser::build(const std::vector<std::string> &capture_values, const std::string &attr_name) const {
@@ -159,10 +70,7 @@ std::string KeyParser::build(const std::vector<std::string> &capture_values, con
 		if (std::holds_alternative<LiteralSegment>(segment)) {
 			result += std::get<LiteralSegment>(segment).text;
 		} else if (std::holds_alternative<CaptureSegment>(segment)) {
-			if (capture_values[capture_idx].empty()) {
-				throw std::invalid_argument("Capture value for '" + std::get<CaptureSegment>(segment).name +
-				                            "' cannot be empty");
-			}
+			check_capture_value(std::get<CaptureSegment>(segment), capture_values[capture_idx]);
 			result += capture_values[capture_idx];
 			++capture_idx;
 		} else if (std::holds_alternative<AttrSegment>(segment)) {
@@ -173,6 +81,40 @@ std::string KeyParser::build(const std::vector<std::string> &capture_values, con
 	return result;
 }
 
+void KeyParser::check_capture_value(const CaptureSegment &capture, const std::string &value) const {
+	if (value.empty()) {
+		throw std::invalid_argument("Capture value for '" + capture.name + "' cannot be empty");
+	}
+	auto width = capture_encoding_width(capture.encoding);
+	if (width != 0 && value.size() != width) {
+		throw std::invalid_argument("Capture value for '" + capture.name + "' must be " + std::to_string(width) +
+		                            " encoded bytes");
+	}
+}
+
+void KeyParser::build_parts(const std::vector<std::string> &capture_values, std::string &head,
+                            std::string &tail) const {
+	if (capture_values.size() != pattern_.capture_count()) {
+		throw std::invalid_argument("Expected " + std::to_string(pattern_.capture_count()) + " capture values, got " +
+		                            std::to_string(capture_values.size()));
+	}
+	head.clear();
+	tail.clear();
+	std::string *out = &head;
+	size_t capture_idx = 0;
+	for (const auto &segment : pattern_.segments()) {
+		if (std::holds_alternative<LiteralSegment>(segment)) {
+			*out += std::get<LiteralSegment>(segment).text;
+		} else if (std::holds_alternative<CaptureSegment>(segment)) {
+			check_capture_value(std::get<CaptureSegment>(segment), capture_values[capture_idx]);
+			*out += capture_values[capture_idx];
+			++capture_idx;
+		} else {
+			out = &tail;
+		}
+	}
+}
+
 std::string KeyParser::build(const std::unordered_map<std::string, std::string> &captures,
                              const std::string &attr_name) const {
 	std::vector<std::string> capture_values;
@@ -216,6 +158,13 @@ std::string KeyParser::build_prefix(const std::vector<std::string> &capture_valu
 }
 
 std::optional<std::string> KeyParser::try_get_uniform_delimiter() const {
+	// The SIMD parser handles prefix D capture D ... capture D attr: a leading literal and {attr} last
+	const auto &segments = pattern_.segments();
+	if (!std::holds_alternative<LiteralSegment>(segments.front()) ||
+	    !std::holds_alternative<AttrSegment>(segments.back())) {
+		return std::nullopt;
+	}
+
 	std::string delimiter;
 	bool first_literal = true;
 
@@ -246,9 +195,11 @@ std::optional<std::string> KeyParser::try_get_uniform_delimiter() const {
 	return delimiter.empty() ? std::nullopt : std::optional<std::string>(delimiter);
 }
 
-void KeyParser::try_init_simd_parser() {
+void KeyParser::init_parser() {
+	// Fixed-width captures are taken by length, which only the compiled parser does
 	auto uniform_delim = try_get_uniform_delimiter();
-	if (!uniform_delim) {
+	if (!uniform_delim || pattern_.has_typed_captures()) {
+		compiled_parser_ = std::make_unique<CompiledKeyParser>(pattern_);
 		return;
 	}
 
@@ -259,13 +210,38 @@ void KeyParser::try_init_simd_parser() {
 	// The literal_prefix includes the trailing delimiter (e.g., "users##" for
 	// pattern "users##{group}##..."). Strip it because the SIMD parser expects
 	// the first delimiter to appear immediately after the prefix.
-	if (simd_prefix_.size() >= simd_delimiter_.size() &&
-	    simd_prefix_.compare(simd_prefix_.size() - simd_delimiter_.size(), simd_delimiter_.size(), simd_delimiter_) ==
+	if (simd_prefix_.size() < simd_delimiter_.size() ||
+	    simd_prefix_.compare(simd_prefix_.size() - simd_delimiter_.size(), simd_delimiter_.size(), simd_delimiter_) !=
 	        0) {
-		simd_prefix_.resize(simd_prefix_.size() - simd_delimiter_.size());
+		// e.g. "users:{group}##{id}##{attr}" - the prefix doesn't end with the delimiter
+		compiled_parser_ = std::make_unique<CompiledKeyParser>(pattern_);
+		return;
+	}
+	simd_prefix_.resize(simd_prefix_.size() - simd_delimiter_.size());
+
+	switch (pattern_.capture_count()) {
+	case 1:
+		fixed_parser_.emplace(std::in_place_type<SimdKeyParserN<1>>, simd_prefix_, simd_delimiter_);
+		break;
+	case 2:
+		fixed_parser_.emplace(std::in_place_type<SimdKeyParserN<2>>, simd_prefix_, simd_delimiter_);
+		break;
+	case 3:
+		fixed_parser_.emplace(std::in_place_type<SimdKeyParserN<3>>, simd_prefix_, simd_delimiter_);
+		break;
+	case 4:
+		fixed_parser_.emplace(std::in_place_type<SimdKeyParserN<4>>, simd_prefix_, simd_delimiter_);
+		break;
+	case 5:
+		fixed_parser_.emplace(std::in_place_type<SimdKeyParserN<5>>, simd_prefix_, simd_delimiter_);
+		break;
+	case 6:
+		fixed_parser_.emplace(std::in_place_type<SimdKeyParserN<6>>, simd_prefix_, simd_delimiter_);
+		break;
+	default:
+		simd_parser_ = std::make_unique<SimdKeyParser>(simd_prefix_, simd_delimiter_, pattern_.capture_count());
+		break;
 	}
-
-	simd_parser_ = std::make_unique<SimdKeyParser>(simd_prefix_, simd_delimiter_, pattern_.capture_count());
 }
 
 } // namespace level_pivot
@@ -4,10 +4,37 @@
 
 namespace level_pivot {
 
-KeyPattern::KeyPattern(const std::string &pattern) : pattern_(pattern) {
+namespace {
+
+struct EncodingInfo {
+	CaptureEncoding encoding;
+	const char *name;
+	size_t width;
+};
+
+const EncodingInfo ENCODINGS[] = {
+    {CaptureEncoding::TEXT, "text", 0},   {CaptureEncoding::I32BE, "i32be", 4}, {CaptureEncoding::I64BE, "i64be", 8},
+    {CaptureEncoding::U32BE, "u32be", 4}, {CaptureEncoding::U64BE, "u64be", 8}, {CaptureEncoding::DATE, "date", 10},
+};
+
+const EncodingInfo &encoding_info(CaptureEncoding encoding) {
+	return ENCODINGS[static_cast<size_t>(encoding)];
+}
+
+} // anonymous namespace
+
+size_t capture_encoding_width(CaptureEncoding encoding) {
+	return encoding_info(encoding).width;
+}
+
+const char *capture_encoding_name(CaptureEncoding encoding) {
+	return encoding_info(encoding).name;
+}
+
+KeyPattern::KeyPattern(const std::string &pattern, bool require_attr) : pattern_(pattern) {
 	parse(pattern);
 	compute_literal_prefix();
-	validate();
+	validate(require_attr);
 }
 
 void KeyPattern::parse(const std::string &pattern) {
@@ -36,6 +63,27 @@ void KeyPattern::parse(const std::string &pattern) {
 				throw KeyPatternError("Empty placeholder '{}' in pattern");
 			}
 
+			// {name:encoding} stores the capture in a typed encoding
+			auto encoding = CaptureEncoding::TEXT;
+			auto colon = name.find(':');
+			if (colon != std::string::npos) {
+				auto encoding_name = name.substr(colon + 1);
+				name.resize(colon);
+				auto it = std::find_if(std::begin(ENCODINGS), std::end(ENCODINGS),
+				                       [&](const EncodingInfo &info) { return encoding_name == info.name; });
+				if (it == std::end(ENCODINGS)) {
+					throw KeyPatternError("Unknown encoding '" + encoding_name + "' for capture '" + name +
+					                      "' (expected text, i32be, i64be, u32be, u64be or date)");
+				}
+				if (name.empty()) {
+					throw KeyPatternError("Encoding '" + encoding_name + "' needs a capture name");
+				}
+				if (name == "attr") {
+					throw KeyPatternError("{attr} cannot have an encoding");
+				}
+				encoding = it->encoding;
+			}
+
 			for (char c : name) {
 				if (!std::isalnum(c) && c != '_') {
 					throw KeyPatternError("Invalid character '" + std::string(1, c) + "' in placeholder name '" + name +
@@ -50,12 +98,14 @@ void KeyPattern::parse(const std::string &pattern) {
 				segments_.emplace_back(AttrSegment {});
 				has_attr_ = true;
 				attr_index_ = static_cast<int>(segments_.size()) - 1;
+				captures_before_attr_ = capture_names_.size();
 			} else {
 				if (std::find(capture_names_.begin(), capture_names_.end(), name) != capture_names_.end()) {
 					throw KeyPatternError("Duplicate capture name '" + name + "' in pattern");
 				}
-				segments_.emplace_back(CaptureSegment {name});
+				segments_.emplace_back(CaptureSegment {name, encoding});
 				capture_names_.push_back(name);
+				capture_encodings_.push_back(encoding);
 			}
 
 			pos = end + 1;
@@ -68,6 +118,9 @@ void KeyPattern::parse(const std::string &pattern) {
 	if (!current_literal.empty()) {
 		segments_.emplace_back(LiteralSegment {current_literal});
 	}
+	if (!has_attr_) {
+		captures_before_attr_ = capture_names_.size();
+	}
 }
 
 void KeyPattern::compute_literal_prefix() {
@@ -81,12 +134,12 @@ void KeyPattern::compute_literal_prefix() {
 	}
 }
 
-void KeyPattern::validate() const {
+void KeyPattern::validate(bool require_attr) const {
 	if (segments_.empty()) {
 		throw KeyPatternError("Pattern must have at least one segment");
 	}
 
-	if (!has_attr_) {
+	if (require_attr && !has_attr_) {
 		throw KeyPatternError("Pattern must contain {attr} segment");
 	}
 
@@ -111,6 +164,11 @@ void KeyPattern::validate() const {
 	}
 }
 
+bool KeyPattern::has_typed_captures() const {
+	return std::any_of(capture_encodings_.begin(), capture_encodings_.end(),
+	                   [](CaptureEncoding encoding) { return encoding != CaptureEncoding::TEXT; });
+}
+
 bool KeyPattern::has_capture(std::string_view name) const {
 	for (auto &n : capture_names_) {
 		if (n == name) {
@@ -129,4 +187,21 @@ int KeyPattern::capture_index(std::string_view name) const {
 	return -1;
 }
 
+std::string_view KeyPattern::delimiter_after_capture(size_t capture_idx) const {
+	size_t seen = 0;
+	for (size_t i = 0; i < segments_.size(); ++i) {
+		if (!std::holds_alternative<CaptureSegment>(segments_[i])) {
+			continue;
+		}
+		if (seen++ != capture_idx) {
+			continue;
+		}
+		if (i + 1 < segments_.size() && std::holds_alternative<LiteralSegment>(segments_[i + 1])) {
+			return std::get<LiteralSegment>(segments_[i + 1]).text;
+		}
+		return std::string_view();
+	}
+	return std::string_view();
+}
+
 } // namespace level_pivot
@@ -0,0 +1,285 @@
+#include "level_pivot_catalog.hpp"
+#include "level_pivot_schema.hpp"
+#include "level_pivot_table_entry.hpp"
+#include "level_pivot_transaction.hpp"
+#include "level_pivot_utils.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include "duckdb/common/types/hyperloglog.hpp"
+#include "duckdb/storage/statistics/base_statistics.hpp"
+
+namespace duckdb {
+
+// Running statistics for one column during level_pivot_analyze
+struct ColumnStatsCollector {
+	LevelPivotColumnStats stats;
+	HyperLogLog distinct;
+	bool keep_bounds = false;
+
+	void Add(const Value &val) {
+		if (val.IsNull()) {
+			stats.null_count++;
+			return;
+		}
+		stats.non_null_count++;
+		distinct.InsertElement(val.Hash());
+		if (!keep_bounds) {
+			return;
+		}
+		if (stats.min.IsNull() || val < stats.min) {
+			stats.min = val;
+		}
+		if (stats.max.IsNull() || val > stats.max) {
+			stats.max = val;
+		}
+	}
+
+	void AddNull() {
+		stats.null_count++;
+	}
+};
+
+// One pass over the table's keys, assembling rows the same way the scan does
+static void CollectPivotStatistics(LevelPivotTableEntry &table, const level_pivot::LevelDBWriteSet *overlay,
+                                   vector<ColumnStatsCollector> &collectors) {
+	auto &parser = table.GetKeyParser();
+	auto &pattern = parser.pattern();
+	auto &columns = table.GetColumns();
+	auto num_captures = pattern.capture_count();
+
+	// Per-capture column index, and attr name -> column index
+	vector<idx_t> capture_columns;
+	for (auto &cap_name : pattern.capture_names()) {
+		capture_columns.push_back(table.GetColumnIndex(cap_name));
+	}
+	vector<std::string_view> attr_keys;
+	vector<idx_t> attr_columns;
+	auto &attr_cols = table.GetAttrColumns();
+	for (idx_t a = 0; a < attr_cols.size(); a++) {
+		attr_keys.push_back(table.GetAttrKey(a));
+		attr_columns.push_back(table.GetColumnIndex(attr_cols[a]));
+	}
+	AttrDispatch attr_dispatch;
+	table.InitializeAttrDispatch(attr_dispatch, attr_keys);
+	vector<bool> attr_seen(columns.LogicalColumnCount(), false);
+
+	auto finish_row = [&]() {
+		for (auto col_idx : attr_columns) {
+			if (!attr_seen[col_idx]) {
+				collectors[col_idx].AddNull();
+			}
+			attr_seen[col_idx] = false;
+		}
+	};
+
+	auto prefix = table.GetKeyPrefix();
+	auto end = PrefixSuccessor(prefix);
+	auto iter = table.GetConnection()->iterator(overlay);
+	if (prefix.empty()) {
+		iter.seek_to_first();
+	} else {
+		iter.seek(prefix);
+	}
+
+	std::string_view captures[level_pivot::MAX_KEY_CAPTURES];
+	std::string_view attr;
+	std::vector<std::string> identity;
+	bool has_identity = false;
+	for (; iter.valid() && IsBeforeEnd(iter.key_view(), end); iter.next()) {
+		if (IsMetadataKey(iter.key_view()) || !parser.parse_fast(iter.key_view(), captures, attr)) {
+			continue;
+		}
+		if (!has_identity || !IdentityMatches(identity, captures, num_captures)) {
+			if (has_identity) {
+				finish_row();
+			}
+			identity.resize(num_captures);
+			for (size_t i = 0; i < num_captures; i++) {
+				identity[i].assign(captures[i].data(), captures[i].size());
+				auto col_idx = capture_columns[i];
+				auto &type = columns.GetColumn(LogicalIndex(col_idx)).Type();
+				collectors[col_idx].Add(CaptureToTypedValue(pattern.capture_encoding(i), captures[i], type));
+			}
+			has_identity = true;
+		}
+		auto a = attr_dispatch.Find(attr);
+		if (a == DConstants::INVALID_INDEX || attr_seen[attr_columns[a]]) {
+			continue;
+		}
+		auto col_idx = attr_columns[a];
+		auto &type = columns.GetColumn(LogicalIndex(col_idx)).Type();
+		collectors[col_idx].Add(StoredToTypedValue(iter.value_view(), type, table.GetValueEncoding(col_idx)));
+		attr_seen[col_idx] = true;
+	}
+	if (has_identity) {
+		finish_row();
+	}
+}
+
+// Packed keys are whole rows: captures from the key, attrs from the packed value
+static void CollectPackedStatistics(LevelPivotTableEntry &table, const level_pivot::LevelDBWriteSet *overlay,
+                                    vector<ColumnStatsCollector> &collectors) {
+	auto &parser = table.GetKeyParser();
+	auto &pattern = parser.pattern();
+	auto &columns = table.GetColumns();
+	auto num_captures = pattern.capture_count();
+
+	vector<idx_t> capture_columns;
+	for (auto &cap_name : pattern.capture_names()) {
+		capture_columns.push_back(table.GetColumnIndex(cap_name));
+	}
+	vector<idx_t> attr_columns;
+	for (auto &attr_name : table.GetAttrColumns()) {
+		attr_columns.push_back(table.GetColumnIndex(attr_name));
+	}
+	vector<std::string_view> fields(attr_columns.size());
+	auto present = make_unsafe_uniq_array<bool>(attr_columns.size() + 1);
+
+	auto prefix = table.GetKeyPrefix();
+	auto end = PrefixSuccessor(prefix);
+	auto iter = table.GetConnection()->iterator(overlay);
+	if (prefix.empty()) {
+		iter.seek_to_first();
+	} else {
+		iter.seek(prefix);
+	}
+
+	std::string_view captures[level_pivot::MAX_KEY_CAPTURES];
+	std::string_view attr;
+	for (; iter.valid() && IsBeforeEnd(iter.key_view(), end); iter.next()) {
+		if (IsMetadataKey(iter.key_view()) || !parser.parse_fast(iter.key_view(), captures, attr)) {
+			continue;
+		}
+		if (!level_pivot::unpack_row(iter.value_view(), attr_columns.size(), fields.data(), present.get())) {
+			throw InvalidInputException("Value of key '%s' is not a packed row", iter.key());
+		}
+		for (size_t i = 0; i < num_captures; i++) {
+			auto col_idx = capture_columns[i];
+			auto &type = columns.GetColumn(LogicalIndex(col_idx)).Type();
+			collectors[col_idx].Add(CaptureToTypedValue(pattern.capture_encoding(i), captures[i], type));
+		}
+		for (idx_t a = 0; a < attr_columns.size(); a++) {
+			auto col_idx = attr_columns[a];
+			if (!present[a]) {
+				collectors[col_idx].AddNull();
+				continue;
+			}
+			auto &type = columns.GetColumn(LogicalIndex(col_idx)).Type();
+			collectors[col_idx].Add(StoredToTypedValue(fields[a], type, table.GetValueEncoding(col_idx)));
+		}
+	}
+}
+
+static void CollectRawStatistics(LevelPivotTableEntry &table, const level_pivot::LevelDBWriteSet *overlay,
+                                 vector<ColumnStatsCollector> &collectors) {
+	auto &columns = table.GetColumns();
+	auto &key_type = columns.GetColumn(LogicalIndex(0)).Type();
+	auto &value_type = columns.GetColumn(LogicalIndex(1)).Type();
+	auto value_encoding = table.GetValueEncoding(1);
+
+	auto iter = table.GetConnection()->iterator(overlay);
+	for (iter.seek_to_first(); iter.valid(); iter.next()) {
+		if (IsMetadataKey(iter.key_view())) {
+			continue;
+		}
+		collectors[0].Add(StringToTypedValue(iter.key_view(), key_type));
+		collectors[1].Add(StoredToTypedValue(iter.value_view(), value_type, value_encoding));
+	}
+}
+
+struct AnalyzeBindData : public TableFunctionData {
+	string catalog_name;
+	string table_name;
+	vector<string> column_names;
+	vector<LevelPivotColumnStats> stats;
+	bool analyzed = false;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> AnalyzeBind(ClientContext &context, TableFunctionBindInput &input,
+                                            vector<LogicalType> &return_types, vector<string> &names) {
+	auto data = make_uniq<AnalyzeBindData>();
+	data->catalog_name = input.inputs[0].GetValue<string>();
+	data->table_name = input.inputs[1].GetValue<string>();
+
+	return_types.push_back(LogicalType::VARCHAR);
+	names.push_back("column_name");
+	return_types.push_back(LogicalType::VARCHAR);
+	names.push_back("min");
+	return_types.push_back(LogicalType::VARCHAR);
+	names.push_back("max");
+	return_types.push_back(LogicalType::DOUBLE);
+	names.push_back("null_fraction");
+	return_types.push_back(LogicalType::BIGINT);
+	names.push_back("distinct_count");
+
+	return std::move(data);
+}
+
+static void AnalyzeFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &bind_data = data.bind_data->CastNoConst<AnalyzeBindData>();
+
+	if (!bind_data.analyzed) {
+		auto &catalog = Catalog::GetCatalog(context, bind_data.catalog_name);
+		auto &lp_catalog = catalog.Cast<LevelPivotCatalog>();
+		auto table_ptr = lp_catalog.GetMainSchema().GetTable(bind_data.table_name);
+		if (!table_ptr) {
+			throw CatalogException("Table '%s' does not exist in '%s'", bind_data.table_name, bind_data.catalog_name);
+		}
+		auto &table = *table_ptr;
+
+		vector<ColumnStatsCollector> collectors(table.GetColumns().LogicalColumnCount());
+		for (auto &col : table.GetColumns().Logical()) {
+			auto stats_type = BaseStatistics::GetStatsType(col.Type());
+			collectors[col.Logical().index].keep_bounds =
+			    stats_type == StatisticsType::NUMERIC_STATS || stats_type == StatisticsType::STRING_STATS;
+			bind_data.column_names.push_back(col.Name());
+		}
+		// Read the table as this transaction sees it, including its buffered writes
+		auto &txn = LevelPivotTransaction::Get(context, catalog);
+		auto overlay = txn.GetReadOverlay();
+		auto version = table.GetStatisticsVersion();
+		if (table.GetTableMode() == LevelPivotTableMode::PIVOT) {
+			CollectPivotStatistics(table, overlay, collectors);
+		} else if (table.GetTableMode() == LevelPivotTableMode::PACKED) {
+			CollectPackedStatistics(table, overlay, collectors);
+		} else {
+			CollectRawStatistics(table, overlay, collectors);
+		}
+
+		for (auto &collector : collectors) {
+			collector.stats.distinct_count = collector.distinct.Count();
+			bind_data.stats.push_back(collector.stats);
+		}
+		// Statistics over uncommitted writes are only reported: the commit would drop them, and a rollback would
+		// leave them describing rows that don't exist
+		if (!txn.GetDirtyTables().count(table.name)) {
+			table.SetAnalyzedStatistics(bind_data.stats, version);
+		}
+		bind_data.analyzed = true;
+	}
+
+	idx_t count = 0;
+	while (bind_data.offset < bind_data.stats.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &stats = bind_data.stats[bind_data.offset];
+		auto total = stats.null_count + stats.non_null_count;
+		output.SetValue(0, count, Value(bind_data.column_names[bind_data.offset]));
+		output.SetValue(1, count, stats.min.IsNull() ? Value() : Value(stats.min.ToString()));
+		output.SetValue(2, count, stats.max.IsNull() ? Value() : Value(stats.max.ToString()));
+		output.SetValue(3, count,
+		                total == 0 ? Value() : Value::DOUBLE(static_cast<double>(stats.null_count) / total));
+		output.SetValue(4, count, Value::BIGINT(static_cast<int64_t>(stats.distinct_count)));
+		bind_data.offset++;
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+TableFunction GetAnalyzeFunction() {
+	TableFunction func("level_pivot_analyze", {LogicalType::VARCHAR, LogicalType::VARCHAR}, AnalyzeFunc,
+	                   AnalyzeBind);
+	return func;
+}
+
+} // namespace duckdb
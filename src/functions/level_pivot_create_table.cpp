@@ -1,9 +1,10 @@
 #include "level_pivot_catalog.hpp"
+#include "level_pivot_table_entry.hpp"
 #include "duckdb/function/table_function.hpp"
 #include "duckdb/main/client_context.hpp"
 #include "duckdb/catalog/catalog.hpp"
+#include "duckdb/common/string_util.hpp"
 #include "duckdb/common/types.hpp"
-#include <algorithm>
 
 namespace duckdb {
 
@@ -13,8 +14,9 @@ struct CreateTableBindData : public TableFunctionData {
 	string pattern;
 	vector<string> column_names;
 	vector<LogicalType> column_types;
-	vector<bool> column_json;
-	string table_mode; // "pivot" or "raw"
+	vector<LevelPivotValueEncoding> column_encodings;
+	string table_mode; // "pivot", "packed" or "raw"
+	bool attr_codes = false;
 	bool done = false;
 };
 
@@ -49,23 +51,30 @@ static unique_ptr<FunctionData> CreateTableBind(ClientContext &context, TableFun
 		}
 		for (auto &type_val : type_list) {
 			auto type_str = type_val.GetValue<string>();
-			// Check for case-insensitive "JSON " prefix
-			bool is_json = false;
-			if (type_str.size() >= 5) {
-				auto prefix = type_str.substr(0, 5);
-				std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::toupper);
-				if (prefix == "JSON ") {
-					is_json = true;
-					type_str = type_str.substr(5);
+			// Check for a case-insensitive value encoding prefix ("JSON ", "BIN ", "VARINT ")
+			auto encoding = LevelPivotValueEncoding::TEXT;
+			for (auto candidate :
+			     {LevelPivotValueEncoding::JSON, LevelPivotValueEncoding::BIN, LevelPivotValueEncoding::VARINT}) {
+				auto prefix = string(ValueEncodingName(candidate)) + " ";
+				if (type_str.size() > prefix.size() &&
+				    StringUtil::CIEquals(type_str.substr(0, prefix.size()), prefix)) {
+					encoding = candidate;
+					type_str = type_str.substr(prefix.size());
+					break;
 				}
 			}
-			data->column_json.push_back(is_json);
-			data->column_types.push_back(TransformStringToLogicalType(type_str));
+			auto type = TransformStringToLogicalType(type_str);
+			if (!SupportsValueEncoding(encoding, type)) {
+				throw InvalidInputException("Type %s cannot be stored with the %s value encoding", type.ToString(),
+				                            ValueEncodingName(encoding));
+			}
+			data->column_encodings.push_back(encoding);
+			data->column_types.push_back(std::move(type));
 		}
 	} else {
-		// Default: all VARCHAR, no JSON
+		// Default: all VARCHAR, stored as text
 		data->column_types.resize(data->column_names.size(), LogicalType::VARCHAR);
-		data->column_json.resize(data->column_names.size(), false);
+		data->column_encodings.resize(data->column_names.size(), LevelPivotValueEncoding::TEXT);
 	}
 
 	// Check for table_mode named parameter
@@ -75,8 +84,17 @@ static unique_ptr<FunctionData> CreateTableBind(ClientContext &context, TableFun
 		data->table_mode = it->second.GetValue<string>();
 	}
 
-	if (data->table_mode != "pivot" && data->table_mode != "raw") {
-		throw InvalidInputException("Invalid table_mode '%s'. Must be 'pivot' or 'raw'.", data->table_mode);
+	if (data->table_mode != "pivot" && data->table_mode != "packed" && data->table_mode != "raw") {
+		throw InvalidInputException("Invalid table_mode '%s'. Must be 'pivot', 'packed' or 'raw'.",
+		                            data->table_mode);
+	}
+
+	auto codes_it = input.named_parameters.find("attr_codes");
+	if (codes_it != input.named_parameters.end()) {
+		data->attr_codes = BooleanValue::Get(codes_it->second);
+		if (data->attr_codes && data->table_mode != "pivot") {
+			throw InvalidInputException("attr_codes requires table_mode 'pivot'");
+		}
 	}
 
 	// Return type: single boolean column
@@ -99,13 +117,14 @@ static void CreateTableFunc(ClientContext &context, TableFunctionInput &data, Da
 
 	if (bind_data.table_mode == "raw") {
 		lp_catalog.CreateRawTable(bind_data.table_name, bind_data.column_names, bind_data.column_types,
-		                          bind_data.column_json);
+		                          bind_data.column_encodings);
 	} else {
 		if (bind_data.pattern.empty()) {
-			throw InvalidInputException("Pattern is required for pivot tables");
+			throw InvalidInputException("Pattern is required for %s tables", bind_data.table_mode);
 		}
+		auto mode = bind_data.table_mode == "packed" ? LevelPivotTableMode::PACKED : LevelPivotTableMode::PIVOT;
 		lp_catalog.CreatePivotTable(bind_data.table_name, bind_data.pattern, bind_data.column_names,
-		                            bind_data.column_types, bind_data.column_json);
+		                            bind_data.column_types, bind_data.column_encodings, mode, bind_data.attr_codes);
 	}
 
 	output.SetCardinality(1);
@@ -120,6 +139,7 @@ TableFunction GetCreateTableFunction() {
 	    CreateTableFunc, CreateTableBind);
 	func.named_parameters["table_mode"] = LogicalType::VARCHAR;
 	func.named_parameters["column_types"] = LogicalType::LIST(LogicalType::VARCHAR);
+	func.named_parameters["attr_codes"] = LogicalType::BOOLEAN;
 	return func;
 }
 
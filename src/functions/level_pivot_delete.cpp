@@ -11,24 +11,41 @@ LevelPivotDelete::LevelPivotDelete(PhysicalPlan &plan, vector<LogicalType> types
 }
 
 unique_ptr<GlobalSinkState> LevelPivotDelete::GetGlobalSinkState(ClientContext &context) const {
-	return make_uniq<LevelPivotSinkGlobalState>();
+	return make_uniq<LevelPivotSinkGlobalState>(context, table);
+}
+
+unique_ptr<LocalSinkState> LevelPivotDelete::GetLocalSinkState(ExecutionContext &context) const {
+	return make_uniq<LevelPivotSinkLocalState>(context, table);
 }
 
 SinkResultType LevelPivotDelete::Sink(ExecutionContext &context, DataChunk &chunk, OperatorSinkInput &input) const {
-	auto &gstate = input.global_state.Cast<LevelPivotSinkGlobalState>();
+	auto &lstate = input.local_state.Cast<LevelPivotSinkLocalState>();
 	auto ctx = GetSinkContext(context, table);
+	auto &writes = lstate.writes;
 
-	if (ctx.table.GetTableMode() == LevelPivotTableMode::PIVOT) {
+	if (ctx.table.GetTableMode() == LevelPivotTableMode::PACKED) {
+		// A row is a single key
+		auto &parser = ctx.table.GetKeyParser();
+		auto &identity_encodings = ctx.table.GetIdentityEncodings();
+
+		std::vector<std::string> identity_values;
+		for (idx_t row = 0; row < chunk.size(); row++) {
+			ExtractIdentityValues(identity_values, chunk, row, 0, identity_encodings);
+			auto key = parser.build_prefix(identity_values);
+			writes.del(key);
+			lstate.MarkWritten(ctx, key);
+		}
+	} else if (ctx.table.GetTableMode() == LevelPivotTableMode::PIVOT) {
 		auto &parser = ctx.table.GetKeyParser();
-		auto batch = ctx.connection.create_batch();
-		auto iter = ctx.connection.iterator();
+		auto &identity_encodings = ctx.table.GetIdentityEncodings();
+		auto iter = ctx.connection.iterator(ctx.txn.GetReadOverlay());
 
 		std::vector<std::string> identity_values;
 		identity_values.reserve(chunk.ColumnCount());
 
 		for (idx_t row = 0; row < chunk.size(); row++) {
 			// The child plan emits the identity columns (from GetRowIdColumns)
-			ExtractIdentityValues(identity_values, chunk, row, 0, chunk.ColumnCount());
+			ExtractIdentityValues(identity_values, chunk, row, 0, identity_encodings);
 
 			// Find all keys matching this identity and delete them
 			std::string prefix = parser.build_prefix(identity_values);
@@ -47,35 +64,34 @@ SinkResultType LevelPivotDelete::Sink(ExecutionContext &context, DataChunk &chun
 				auto parsed = parser.parse_view(key_sv);
 				if (parsed &&
 				    IdentityMatches(identity_values, parsed->capture_values.data(), parsed->capture_values.size())) {
-					batch.del(key_sv);
-					ctx.txn.CheckKeyAgainstTables(key_sv, ctx.schema);
+					writes.del(key_sv);
+					lstate.MarkWritten(ctx, key_sv);
 				}
 				iter.next();
 			}
 		}
-
-		batch.commit();
-		gstate.row_count += chunk.size();
 	} else {
-		auto batch = ctx.connection.create_batch();
 		for (idx_t row = 0; row < chunk.size(); row++) {
 			auto key_val = chunk.data[0].GetValue(row);
 			if (!key_val.IsNull()) {
 				auto key = key_val.ToString();
-				batch.del(key);
-				ctx.txn.CheckKeyAgainstTables(key, ctx.schema);
+				writes.del(key);
+				lstate.MarkWritten(ctx, key);
 			}
 		}
-		batch.commit();
-		gstate.row_count += chunk.size();
 	}
+	lstate.FinishChunk(ctx, input.global_state.Cast<LevelPivotSinkGlobalState>(), chunk.size());
 
 	return SinkResultType::NEED_MORE_INPUT;
 }
 
+SinkCombineResultType LevelPivotDelete::Combine(ExecutionContext &context, OperatorSinkCombineInput &input) const {
+	return CombineSink(input);
+}
+
 SinkFinalizeType LevelPivotDelete::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
                                             OperatorSinkFinalizeInput &input) const {
-	return SinkFinalizeType::READY;
+	return FinalizeSink(context, table, input);
 }
 
 SourceResultType LevelPivotDelete::GetData(ExecutionContext &context, DataChunk &chunk,
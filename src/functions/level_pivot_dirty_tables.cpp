@@ -41,15 +41,15 @@ static unique_ptr<FunctionData> DirtyTablesBind(ClientContext &context, TableFun
 			continue;
 		}
 
-		auto &txn_manager = static_cast<LevelPivotTransactionManager &>(db.GetTransactionManager());
-		auto *txn = txn_manager.GetCurrentTransaction();
-		if (!txn || !txn->HasDirtyTables()) {
+		// This connection's transaction on the database
+		auto &txn = LevelPivotTransaction::Get(context, catalog);
+		if (!txn.HasDirtyTables()) {
 			continue;
 		}
 
 		auto &lp_catalog = catalog.Cast<LevelPivotCatalog>();
 		auto &schema = lp_catalog.GetMainSchema();
-		auto &dirty = txn->GetDirtyTables();
+		auto &dirty = txn.GetDirtyTables();
 		auto db_name = db.GetName();
 
 		for (auto &table_name : dirty) {
@@ -60,7 +60,7 @@ static unique_ptr<FunctionData> DirtyTablesBind(ClientContext &context, TableFun
 			DirtyTableRow row;
 			row.database_name = db_name;
 			row.table_name = table_name;
-			row.table_mode = table_ptr->GetTableMode() == LevelPivotTableMode::PIVOT ? "pivot" : "raw";
+			row.table_mode = TableModeName(table_ptr->GetTableMode());
 			data->rows.push_back(std::move(row));
 		}
 	}
@@ -5,91 +5,146 @@
 
 namespace duckdb {
 
+// Per-thread writes, reader and key buffers, reused across chunks
+struct LevelPivotInsertLocalState : public LevelPivotSinkLocalState {
+	using LevelPivotSinkLocalState::LevelPivotSinkLocalState;
+
+	StoredInput input;
+	std::vector<std::string> identity_values; // encoded, in capture order
+	std::string key_head;                     // key up to {attr} (the whole key without one)
+	std::string key_tail;                     // key after {attr}
+	std::string key;
+	unique_ptr<PackedRowBuilder> packed_row; // packed mode only
+};
+
 LevelPivotInsert::LevelPivotInsert(PhysicalPlan &plan, vector<LogicalType> types, TableCatalogEntry &table,
                                    idx_t estimated_cardinality)
     : PhysicalOperator(plan, PhysicalOperatorType::EXTENSION, std::move(types), estimated_cardinality), table(table) {
+	auto &lp_table = table.Cast<LevelPivotTableEntry>();
+	if (!lp_table.HasKeyPattern()) {
+		return;
+	}
+	for (auto &cap_name : lp_table.GetKeyParser().pattern().capture_names()) {
+		capture_columns.push_back(lp_table.GetColumnIndex(cap_name));
+	}
+	for (auto &attr_name : lp_table.GetAttrColumns()) {
+		attr_columns.push_back(lp_table.GetColumnIndex(attr_name));
+	}
 }
 
 unique_ptr<GlobalSinkState> LevelPivotInsert::GetGlobalSinkState(ClientContext &context) const {
-	return make_uniq<LevelPivotSinkGlobalState>();
+	return make_uniq<LevelPivotSinkGlobalState>(context, table);
+}
+
+unique_ptr<LocalSinkState> LevelPivotInsert::GetLocalSinkState(ExecutionContext &context) const {
+	auto &lp_table = table.Cast<LevelPivotTableEntry>();
+	auto types = lp_table.GetColumns().GetColumnTypes();
+	auto lstate = make_uniq<LevelPivotInsertLocalState>(context, table);
+
+	vector<StoredInputForm> forms(types.size(), StoredInputForm::SKIP);
+	if (lp_table.HasKeyPattern()) {
+		auto &pattern = lp_table.GetKeyParser().pattern();
+		for (idx_t c = 0; c < capture_columns.size(); c++) {
+			auto col_idx = capture_columns[c];
+			forms[col_idx] = StoredInput::FormOf(pattern.capture_encoding(c), types[col_idx]);
+		}
+		for (auto col_idx : attr_columns) {
+			forms[col_idx] = StoredInput::FormOf(lp_table.GetValueEncoding(col_idx));
+		}
+		lstate->identity_values.resize(capture_columns.size());
+		if (lp_table.GetTableMode() == LevelPivotTableMode::PACKED) {
+			lstate->packed_row = make_uniq<PackedRowBuilder>(attr_columns.size());
+		}
+	} else {
+		// Raw mode: column 0 = key, column 1 = value
+		forms[0] = StoredInputForm::TEXT;
+		forms[1] = StoredInput::FormOf(lp_table.GetValueEncoding(1));
+	}
+	lstate->input.Initialize(types, forms);
+	return std::move(lstate);
 }
 
 SinkResultType LevelPivotInsert::Sink(ExecutionContext &context, DataChunk &chunk, OperatorSinkInput &input) const {
-	auto &gstate = input.global_state.Cast<LevelPivotSinkGlobalState>();
+	auto &lstate = input.local_state.Cast<LevelPivotInsertLocalState>();
 	auto ctx = GetSinkContext(context, table);
+	auto &writes = lstate.writes;
+	auto &in = lstate.input;
+	in.Load(chunk);
 
-	if (ctx.table.GetTableMode() == LevelPivotTableMode::PIVOT) {
+	if (ctx.table.HasKeyPattern()) {
 		auto &parser = ctx.table.GetKeyParser();
-		auto &attr_cols = ctx.table.GetAttrColumns();
-
-		auto batch = ctx.connection.create_batch();
-		auto &capture_names = parser.pattern().capture_names();
-
-		std::vector<std::string> identity_values;
-		identity_values.reserve(capture_names.size());
+		auto &pattern = parser.pattern();
+		auto &capture_names = pattern.capture_names();
 
 		for (idx_t row = 0; row < chunk.size(); row++) {
-			// Extract identity values in capture order
-			identity_values.clear();
-			for (auto &cap_name : capture_names) {
-				auto col_idx = ctx.table.GetColumnIndex(cap_name);
-				auto val = chunk.data[col_idx].GetValue(row);
-				if (val.IsNull()) {
-					throw InvalidInputException("Cannot insert NULL into identity column '%s'", cap_name);
+			// Encode identity values in capture order
+			for (idx_t c = 0; c < capture_columns.size(); c++) {
+				auto col_idx = capture_columns[c];
+				if (in.IsNull(col_idx, row)) {
+					throw InvalidInputException("Cannot insert NULL into identity column '%s'", capture_names[c]);
+				}
+				auto encoding = pattern.capture_encoding(c);
+				if (!in.EncodeCapture(col_idx, row, encoding, lstate.identity_values[c])) {
+					throw InvalidInputException("Value '%s' does not fit the %s encoding of identity column '%s'",
+					                            chunk.data[col_idx].GetValue(row).ToString(),
+					                            level_pivot::capture_encoding_name(encoding), capture_names[c]);
 				}
-				identity_values.push_back(val.ToString());
 			}
+			parser.build_parts(lstate.identity_values, lstate.key_head, lstate.key_tail);
 
-			// Write a key for each non-null attr column
-			for (auto &attr_name : attr_cols) {
-				auto col_idx = ctx.table.GetColumnIndex(attr_name);
-				auto val = chunk.data[col_idx].GetValue(row);
-				if (!val.IsNull()) {
-					std::string key = parser.build(identity_values, attr_name);
-					if (ctx.table.IsJsonColumn(col_idx)) {
-						auto &col_type = ctx.table.GetColumns().GetColumn(LogicalIndex(col_idx)).Type();
-						batch.put(key, TypedValueToJsonString(val, col_type));
+			if (lstate.packed_row) {
+				// One key holding every attr; it replaces the whole row
+				auto &packed_row = *lstate.packed_row;
+				for (idx_t a = 0; a < attr_columns.size(); a++) {
+					auto col_idx = attr_columns[a];
+					if (in.IsNull(col_idx, row)) {
+						packed_row.SetNull(a);
 					} else {
-						batch.put(key, val.ToString());
+						packed_row.SetStored(a, in.Stored(col_idx, row, ctx.table.GetValueEncoding(col_idx)));
 					}
-					ctx.txn.CheckKeyAgainstTables(key, ctx.schema);
 				}
+				writes.put(lstate.key_head, packed_row.Pack());
+				lstate.MarkWritten(ctx, lstate.key_head);
+				continue;
 			}
-		}
 
-		batch.commit();
-		gstate.row_count += chunk.size();
+			// Write a key for each non-null attr column
+			for (idx_t a = 0; a < attr_columns.size(); a++) {
+				auto col_idx = attr_columns[a];
+				if (in.IsNull(col_idx, row)) {
+					continue;
+				}
+				lstate.key.assign(lstate.key_head);
+				lstate.key += ctx.table.GetAttrKey(a);
+				lstate.key += lstate.key_tail;
+				writes.put(lstate.key, in.Stored(col_idx, row, ctx.table.GetValueEncoding(col_idx)));
+				lstate.MarkWritten(ctx, lstate.key);
+			}
+		}
 	} else {
 		// Raw mode: column 0 = key, column 1 = value
-		bool val_is_json = ctx.table.IsJsonColumn(1);
-		auto &val_col_type = ctx.table.GetColumns().GetColumn(LogicalIndex(1)).Type();
-		auto batch = ctx.connection.create_batch();
+		auto val_encoding = ctx.table.GetValueEncoding(1);
 		for (idx_t row = 0; row < chunk.size(); row++) {
-			auto key_val = chunk.data[0].GetValue(row);
-			auto val_val = chunk.data[1].GetValue(row);
-			if (key_val.IsNull()) {
+			if (in.IsNull(0, row)) {
 				throw InvalidInputException("Cannot insert NULL key in raw mode");
 			}
-			std::string key = key_val.ToString();
-			if (val_val.IsNull()) {
-				batch.put(key, "");
-			} else if (val_is_json) {
-				batch.put(key, TypedValueToJsonString(val_val, val_col_type));
-			} else {
-				batch.put(key, val_val.ToString());
-			}
-			ctx.txn.CheckKeyAgainstTables(key, ctx.schema);
+			auto key = in.Text(0, row);
+			writes.put(key, in.IsNull(1, row) ? std::string_view() : in.Stored(1, row, val_encoding));
+			lstate.MarkWritten(ctx, key);
 		}
-		batch.commit();
-		gstate.row_count += chunk.size();
 	}
+	lstate.FinishChunk(ctx, input.global_state.Cast<LevelPivotSinkGlobalState>(), chunk.size());
 
 	return SinkResultType::NEED_MORE_INPUT;
 }
 
+SinkCombineResultType LevelPivotInsert::Combine(ExecutionContext &context, OperatorSinkCombineInput &input) const {
+	return CombineSink(input);
+}
+
 SinkFinalizeType LevelPivotInsert::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
                                             OperatorSinkFinalizeInput &input) const {
-	return SinkFinalizeType::READY;
+	return FinalizeSink(context, table, input);
 }
 
 SourceResultType LevelPivotInsert::GetData(ExecutionContext &context, DataChunk &chunk,
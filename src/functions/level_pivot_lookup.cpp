@@ -0,0 +1,333 @@
+#include "level_pivot_catalog.hpp"
+#include "level_pivot_schema.hpp"
+#include "level_pivot_table_entry.hpp"
+#include "level_pivot_utils.hpp"
+#include "key_parser.hpp"
+#include "level_pivot_storage.hpp"
+#include "level_pivot_transaction.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include <algorithm>
+
+namespace duckdb {
+
+// Keys stepped over with next() before a lookup falls back to a full seek
+static constexpr idx_t MAX_STEPS_BEFORE_SEEK = 8;
+
+struct LookupEntry {
+	string prefix; // identity prefix - every key of the identity starts with it
+	vector<string> identity;
+};
+
+// Sorted lookups and a forward-only iterator over them
+struct LookupCursor {
+	vector<LookupEntry> entries;
+	bool sorted = false;
+	idx_t next = 0;
+	std::unique_ptr<level_pivot::LevelDBIterator> iterator;
+	const level_pivot::LevelDBWriteSet *overlay = nullptr; // the transaction's buffered writes (nullptr = none)
+	bool positioned = false;
+	StagedOutput output_writer;
+	AttrDispatch attr_dispatch; // attr key -> LookupBindData::attr_columns index
+};
+
+struct LookupBindData : public TableFunctionData {
+	LevelPivotTableEntry *table_entry;
+	// List form only; the table form streams its identities in
+	vector<vector<string>> identities;
+	vector<pair<string, idx_t>> attr_columns; // attr key (see GetAttrKey) -> output column
+	vector<idx_t> capture_columns;            // capture index -> output column
+};
+
+struct LookupGlobalState : public GlobalTableFunctionState {
+	LookupCursor cursor;
+};
+
+struct LookupLocalState : public LocalTableFunctionState {
+	LookupCursor cursor;
+};
+
+static LevelPivotTableEntry &GetLookupTable(ClientContext &context, const string &catalog_name,
+                                            const string &table_name) {
+	auto &catalog = Catalog::GetCatalog(context, catalog_name);
+	if (catalog.GetCatalogType() != "level_pivot") {
+		throw InvalidInputException("'%s' is not a level_pivot database", catalog_name);
+	}
+	auto table_ptr = catalog.Cast<LevelPivotCatalog>().GetMainSchema().GetTable(table_name);
+	if (!table_ptr) {
+		throw CatalogException("Table '%s' does not exist in '%s'", table_name, catalog_name);
+	}
+	auto &table = *table_ptr;
+	if (table.GetTableMode() != LevelPivotTableMode::PIVOT) {
+		throw InvalidInputException("level_pivot_lookup only supports pivot tables");
+	}
+	auto &pattern = table.GetKeyParser().pattern();
+	if (pattern.captures_before_attr() != pattern.capture_count()) {
+		throw InvalidInputException("level_pivot_lookup requires {attr} to follow every capture in the key pattern");
+	}
+	return table;
+}
+
+// Shared bind: output columns are the table's columns, identities are given in pattern capture order
+static unique_ptr<LookupBindData> LookupBindCommon(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+	auto data = make_uniq<LookupBindData>();
+	auto &table = GetLookupTable(context, input.inputs[0].GetValue<string>(), input.inputs[1].GetValue<string>());
+	data->table_entry = &table;
+
+	for (auto &col : table.GetColumns().Logical()) {
+		return_types.push_back(col.Type());
+		names.push_back(col.Name());
+	}
+	for (auto &cap_name : table.GetKeyParser().pattern().capture_names()) {
+		data->capture_columns.push_back(table.GetColumnIndex(cap_name));
+	}
+	auto &attr_cols = table.GetAttrColumns();
+	for (idx_t a = 0; a < attr_cols.size(); a++) {
+		data->attr_columns.emplace_back(table.GetAttrKey(a), table.GetColumnIndex(attr_cols[a]));
+	}
+	return data;
+}
+
+// Key form of a lookup's identity values (in capture order). Returns false if no row can have them: identities
+// never contain NULL, and typed captures only hold values that fit their encoding.
+static bool EncodeLookupIdentity(const level_pivot::KeyPattern &pattern, const vector<Value> &values,
+                                 vector<string> &identity) {
+	identity.resize(values.size());
+	for (idx_t c = 0; c < values.size(); c++) {
+		if (values[c].IsNull() || !TryEncodeCapture(pattern.capture_encoding(c), values[c], identity[c])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static unique_ptr<FunctionData> LookupListBind(ClientContext &context, TableFunctionBindInput &input,
+                                               vector<LogicalType> &return_types, vector<string> &names) {
+	auto data = LookupBindCommon(context, input, return_types, names);
+	auto &pattern = data->table_entry->GetKeyParser().pattern();
+	auto num_captures = data->capture_columns.size();
+	if (input.inputs[2].IsNull()) {
+		return std::move(data);
+	}
+	vector<string> identity;
+	for (auto &tuple : ListValue::GetChildren(input.inputs[2])) {
+		if (tuple.IsNull()) {
+			continue;
+		}
+		auto &values = ListValue::GetChildren(tuple);
+		if (values.size() != num_captures) {
+			throw InvalidInputException("level_pivot_lookup: identity tuples need %d values (one per capture), got %d",
+			                            num_captures, values.size());
+		}
+		if (!EncodeLookupIdentity(pattern, values, identity)) {
+			continue;
+		}
+		data->identities.push_back(std::move(identity));
+	}
+	return std::move(data);
+}
+
+static unique_ptr<FunctionData> LookupTableBind(ClientContext &context, TableFunctionBindInput &input,
+                                                vector<LogicalType> &return_types, vector<string> &names) {
+	auto data = LookupBindCommon(context, input, return_types, names);
+	if (input.input_table_types.size() != data->capture_columns.size()) {
+		throw InvalidInputException("level_pivot_lookup: the input table needs %d columns (one per capture), got %d",
+		                            data->capture_columns.size(), input.input_table_types.size());
+	}
+	return std::move(data);
+}
+
+static void AddLookup(LevelPivotTableEntry &table, LookupCursor &cursor, vector<string> identity) {
+	LookupEntry entry;
+	entry.prefix = table.GetKeyParser().build_prefix(identity);
+	entry.identity = std::move(identity);
+	cursor.entries.push_back(std::move(entry));
+}
+
+// Sort lookups into key order (dropping duplicates) so one iterator can walk them front to back
+static void SortLookups(LookupCursor &cursor) {
+	std::sort(cursor.entries.begin(), cursor.entries.end(),
+	          [](const LookupEntry &a, const LookupEntry &b) { return a.prefix < b.prefix; });
+	auto last = std::unique(cursor.entries.begin(), cursor.entries.end(),
+	                        [](const LookupEntry &a, const LookupEntry &b) { return a.prefix == b.prefix; });
+	cursor.entries.erase(last, cursor.entries.end());
+	cursor.sorted = true;
+}
+
+// Position the iterator at the first key >= prefix. Lookups arrive in key order, so the iterator only ever
+// moves forward: it may already be there, or a few next() calls away, before a real seek is needed.
+static void AdvanceTo(level_pivot::LevelDBIterator &iter, bool &positioned, const string &prefix) {
+	if (positioned) {
+		for (idx_t step = 0; step < MAX_STEPS_BEFORE_SEEK; step++) {
+			if (!iter.valid() || iter.key_view() >= prefix) {
+				return;
+			}
+			iter.next();
+		}
+		if (!iter.valid() || iter.key_view() >= prefix) {
+			return;
+		}
+	}
+	iter.seek(prefix);
+	positioned = true;
+}
+
+// Fill output with the rows of the next lookups, pivoting each identity's keys like the pivot scan does
+static void EmitLookupRows(const LookupBindData &bind_data, LookupCursor &cursor, DataChunk &output) {
+	auto &table = *bind_data.table_entry;
+	auto &parser = table.GetKeyParser();
+	auto &pattern = parser.pattern();
+	auto &columns = table.GetColumns();
+	auto num_captures = bind_data.capture_columns.size();
+	auto &attr_columns = bind_data.attr_columns;
+
+	if (!cursor.iterator) {
+		cursor.iterator =
+		    std::make_unique<level_pivot::LevelDBIterator>(table.GetConnection()->iterator(cursor.overlay));
+		vector<bool> stage;
+		for (auto &col : columns.Logical()) {
+			stage.push_back(NeedsStaging(col.Type(), table.GetValueEncoding(col.Logical().index)));
+		}
+		for (idx_t c = 0; c < num_captures; c++) {
+			auto col_idx = bind_data.capture_columns[c];
+			if (IsNativeCaptureType(pattern.capture_encoding(c), columns.GetColumn(LogicalIndex(col_idx)).Type())) {
+				stage[col_idx] = false;
+			}
+		}
+		cursor.output_writer.Initialize(stage);
+		vector<std::string_view> attr_keys;
+		for (auto &attr_column : attr_columns) {
+			attr_keys.push_back(attr_column.first);
+		}
+		table.InitializeAttrDispatch(cursor.attr_dispatch, attr_keys);
+	}
+	auto &iter = *cursor.iterator;
+
+	std::string_view captures[level_pivot::MAX_KEY_CAPTURES];
+	std::string_view attr;
+	vector<bool> attr_written(attr_columns.size());
+	idx_t count = 0;
+	while (cursor.next < cursor.entries.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &entry = cursor.entries[cursor.next++];
+		AdvanceTo(iter, cursor.positioned, entry.prefix);
+
+		bool found = false;
+		for (; iter.valid() && IsWithinPrefix(iter.key_view(), entry.prefix); iter.next()) {
+			if (!parser.parse_fast(iter.key_view(), captures, attr) ||
+			    !IdentityMatches(entry.identity, captures, num_captures)) {
+				continue;
+			}
+			if (!found) {
+				found = true;
+				std::fill(attr_written.begin(), attr_written.end(), false);
+				for (idx_t c = 0; c < num_captures; c++) {
+					cursor.output_writer.WriteCapture(output, bind_data.capture_columns[c], count, entry.identity[c],
+					                                  pattern.capture_encoding(c));
+				}
+			}
+			auto a = cursor.attr_dispatch.Find(attr);
+			if (a != DConstants::INVALID_INDEX) {
+				auto col_idx = attr_columns[a].second;
+				cursor.output_writer.Write(output, col_idx, count, iter.value_view(), table.GetValueEncoding(col_idx));
+				attr_written[a] = true;
+			}
+		}
+		if (!found) {
+			continue;
+		}
+		for (idx_t a = 0; a < attr_columns.size(); a++) {
+			if (!attr_written[a]) {
+				cursor.output_writer.SetNull(output, attr_columns[a].second, count);
+			}
+		}
+		count++;
+	}
+	cursor.output_writer.Finish(output, count);
+}
+
+// --- List form: level_pivot_lookup('db', 'table', [[v1, v2], ...]) ---
+
+static unique_ptr<GlobalTableFunctionState> LookupListInitGlobal(ClientContext &context,
+                                                                 TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<LookupBindData>();
+	auto result = make_uniq<LookupGlobalState>();
+	auto &catalog = bind_data.table_entry->ParentCatalog();
+	result->cursor.overlay = LevelPivotTransaction::Get(context, catalog).GetReadOverlay();
+	for (auto &identity : bind_data.identities) {
+		AddLookup(*bind_data.table_entry, result->cursor, identity);
+	}
+	SortLookups(result->cursor);
+	return std::move(result);
+}
+
+static void LookupListFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<LookupBindData>();
+	auto &gstate = data.global_state->Cast<LookupGlobalState>();
+	EmitLookupRows(bind_data, gstate.cursor, output);
+}
+
+// --- Table form: level_pivot_lookup('db', 'table', (SELECT v1, v2 FROM ...)) ---
+// Identities are buffered per thread, then sorted and looked up once the input is exhausted.
+
+static unique_ptr<LocalTableFunctionState> LookupTableInitLocal(ExecutionContext &context,
+                                                                TableFunctionInitInput &input,
+                                                                GlobalTableFunctionState *global_state) {
+	auto &table = *input.bind_data->Cast<LookupBindData>().table_entry;
+	auto result = make_uniq<LookupLocalState>();
+	result->cursor.overlay = LevelPivotTransaction::Get(context.client, table.ParentCatalog()).GetReadOverlay();
+	return std::move(result);
+}
+
+static OperatorResultType LookupTableInOut(ExecutionContext &context, TableFunctionInput &data, DataChunk &input,
+                                           DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<LookupBindData>();
+	auto &lstate = data.local_state->Cast<LookupLocalState>();
+	auto &pattern = bind_data.table_entry->GetKeyParser().pattern();
+	auto num_captures = bind_data.capture_columns.size();
+
+	vector<Value> values(num_captures);
+	vector<string> identity;
+	for (idx_t row = 0; row < input.size(); row++) {
+		for (idx_t c = 0; c < num_captures; c++) {
+			values[c] = input.data[c].GetValue(row);
+		}
+		if (EncodeLookupIdentity(pattern, values, identity)) {
+			AddLookup(*bind_data.table_entry, lstate.cursor, std::move(identity));
+		}
+	}
+	output.SetCardinality(0);
+	return OperatorResultType::NEED_MORE_INPUT;
+}
+
+static OperatorFinalizeResultType LookupTableFinal(ExecutionContext &context, TableFunctionInput &data,
+                                                   DataChunk &output) {
+	auto &bind_data = data.bind_data->Cast<LookupBindData>();
+	auto &lstate = data.local_state->Cast<LookupLocalState>();
+	if (!lstate.cursor.sorted) {
+		SortLookups(lstate.cursor);
+	}
+	EmitLookupRows(bind_data, lstate.cursor, output);
+	return lstate.cursor.next < lstate.cursor.entries.size() ? OperatorFinalizeResultType::HAVE_MORE_OUTPUT
+	                                                          : OperatorFinalizeResultType::FINISHED;
+}
+
+TableFunctionSet GetLookupFunctions() {
+	TableFunctionSet set("level_pivot_lookup");
+
+	auto tuple_list = LogicalType::LIST(LogicalType::LIST(LogicalType::VARCHAR));
+	TableFunction list_func({LogicalType::VARCHAR, LogicalType::VARCHAR, tuple_list}, LookupListFunc, LookupListBind,
+	                        LookupListInitGlobal);
+	set.AddFunction(list_func);
+
+	TableFunction table_func({LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::TABLE}, nullptr,
+	                         LookupTableBind, nullptr, LookupTableInitLocal);
+	table_func.in_out_function = LookupTableInOut;
+	table_func.in_out_function_final = LookupTableFinal;
+	set.AddFunction(table_func);
+
+	return set;
+}
+
+} // namespace duckdb
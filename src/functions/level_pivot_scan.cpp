@@ -3,24 +3,42 @@
 #include "level_pivot_utils.hpp"
 #include "key_parser.hpp"
 #include "level_pivot_storage.hpp"
+#include "level_pivot_transaction.hpp"
 #include "duckdb/common/types/data_chunk.hpp"
 #include "duckdb/planner/operator/logical_get.hpp"
 #include "duckdb/planner/expression/bound_comparison_expression.hpp"
 #include "duckdb/planner/expression/bound_constant_expression.hpp"
 #include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_between_expression.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_operator_expression.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include <algorithm>
+#include <optional>
 
 namespace duckdb {
 
-LevelPivotScanGlobalState::LevelPivotScanGlobalState() : done(false) {
+LevelPivotScanGlobalState::LevelPivotScanGlobalState() : next_range(0), completed_weight(0) {
 }
 
-// Mapping from attr name to output column index (sorted by name to match LevelDB order)
+// Ranges handed out per thread; more than one so fast threads can steal work from skewed ranges
+static constexpr idx_t RANGES_PER_THREAD = 4;
+// Don't bother splitting below this many (approximate, on-disk) bytes per range
+static constexpr uint64_t MIN_BYTES_PER_RANGE = static_cast<uint64_t>(1) << 20;
+// Rough cost of a seek in keys stepped over. Rows are read with one seek per projected attr (plus one to leave
+// the row) when that is cheaper than stepping over every declared attr.
+static constexpr idx_t SEEK_COST_IN_KEYS = 8;
+// Ranges sampled for a cardinality estimate. Beyond this (e.g. a long IN list), an evenly spaced subset is sampled
+// and scaled up by the range count.
+static constexpr idx_t MAX_ESTIMATED_RANGES = 16;
+
+// Mapping from attr to output column index (sorted by key bytes to match LevelDB order)
 struct AttrMapping {
-	std::string_view name;
+	std::string_view name; // the attr's bytes in keys (see LevelPivotTableEntry::GetAttrKey)
 	idx_t output_col;
 	LogicalType type;
-	bool is_json;
+	LevelPivotValueEncoding encoding;
+	idx_t packed_index; // position among the table's attr columns, which is its field in a packed row
 };
 
 // Mapping from capture index to output column index
@@ -28,12 +46,36 @@ struct IdentityMapping {
 	idx_t capture_index;
 	idx_t output_col;
 	LogicalType type;
+	level_pivot::CaptureEncoding encoding;
 };
 
 struct LevelPivotScanLocalState : public LocalTableFunctionState {
 	std::unique_ptr<level_pivot::LevelDBIterator> iterator;
-	std::string prefix;
+	const level_pivot::LevelDBWriteSet *overlay = nullptr; // see LevelPivotScanGlobalState
+	const level_pivot::LevelDBSnapshot *snapshot = nullptr;
 	bool initialized = false;
+	StagedOutput output_writer; // typed columns are converted once per chunk
+
+	// Range currently being scanned by this thread
+	idx_t range_idx = 0;
+	std::string range_end;
+	bool range_active = false;
+
+	// Skip-scan settings of the current range (skip_suffix empty = plain scan)
+	idx_t skip_capture = 0;
+	std::string skip_suffix;
+	std::string skip_delimiter;
+	std::string skip_target; // reusable seek key buffer
+
+	// Wide-row mode: seek to each projected attr instead of reading every key of a row
+	bool seek_attrs = false;
+	std::string row_prefix; // key bytes before the attr, shared by all keys of the current row
+	std::string row_suffix; // key bytes after the attr
+	std::string attr_key;   // reusable seek key buffer
+
+	// Identities of the current range when it is a batch of point lookups (nullptr = iterate the range)
+	const vector<vector<string>> *point_identities = nullptr;
+	std::vector<std::optional<std::string>> point_values; // one per attr mapping
 
 	// Zero-alloc parse buffers (reused every key)
 	std::string_view captures_buf[level_pivot::MAX_KEY_CAPTURES];
@@ -42,14 +84,24 @@ struct LevelPivotScanLocalState : public LocalTableFunctionState {
 	// Reusable identity buffer (assign() reuses string capacity after first row)
 	std::vector<std::string> current_identity;
 	bool has_identity = false;
+	// Key bytes before the attr of the current row. Later keys starting with them belong to the same row, so only
+	// their attr is parsed (when every capture precedes the attr).
+	bool incremental_parse = false;
+	std::string identity_span;
 	size_t num_captures = 0;
 
 	// Column lookup tables (built once at init)
 	std::vector<AttrMapping> attr_mappings; // sorted by name to match LevelDB order
+	AttrDispatch attr_dispatch;             // attr name -> attr_mappings index
 	std::vector<IdentityMapping> identity_mappings;
 
 	// Per-row NULL tracking (one flag per attr column)
 	std::vector<bool> attr_written;
+
+	// Packed mode: fields of the current row, unpacked up to the last projected one
+	size_t packed_count = 0;
+	std::vector<std::string_view> packed_fields;
+	unsafe_unique_array<bool> packed_present;
 };
 
 static unique_ptr<FunctionData> LevelPivotBind(ClientContext &context, TableFunctionBindInput &input,
@@ -58,19 +110,210 @@ static unique_ptr<FunctionData> LevelPivotBind(ClientContext &context, TableFunc
 	throw InternalException("LevelPivot scan should not be bound directly");
 }
 
-// Called during optimization to extract equality filters on identity columns.
-// We inspect the expressions and store a narrowed prefix in bind_data for the scan to use.
-// We leave all filters in place so DuckDB still applies them as a post-filter.
+// Resolve a column reference in a pushed-down filter to its table column name
+static bool GetFilterColumnName(LogicalGet &get, BoundColumnRefExpression &col_ref, string &name) {
+	if (col_ref.binding.table_index != get.table_index) {
+		return false;
+	}
+	// Map from output position through column_ids to actual table column index
+	auto output_idx = col_ref.binding.column_index;
+	auto &col_ids = get.GetColumnIds();
+	if (output_idx >= col_ids.size()) {
+		return false;
+	}
+	auto table_col_idx = col_ids[output_idx].GetPrimaryIndex();
+	if (table_col_idx >= get.names.size()) {
+		return false;
+	}
+	name = get.names[table_col_idx];
+	return true;
+}
+
+// A one-sided bound on an identity column; only the tightest bound per column is kept
+struct CaptureBound {
+	string value;
+	bool set = false;
+};
+
+static void TightenLower(CaptureBound &bound, const string &value) {
+	if (!bound.set || value > bound.value) {
+		bound.value = value;
+		bound.set = true;
+	}
+}
+
+static void TightenUpper(CaptureBound &bound, const string &value) {
+	if (!bound.set || value < bound.value) {
+		bound.value = value;
+		bound.set = true;
+	}
+}
+
+// Exclusive stop key covering every key under base whose next capture is <= hi. A capture that is a
+// proper prefix of hi is followed by the delimiter, which may sort after hi's next byte, so each such
+// prefix contributes its own bound. Returns "" if the range is unbounded.
+static string CaptureUpperBound(const string &base, const string &hi, std::string_view delimiter) {
+	string bound = PrefixSuccessor(base + hi);
+	if (bound.empty() || delimiter.empty()) {
+		// Nothing follows a capture that ends the key (packed tables), so its prefixes already sort before hi
+		return bound;
+	}
+	for (size_t len = 1; len < hi.size(); len++) {
+		auto candidate = PrefixSuccessor(base + hi.substr(0, len) + string(delimiter));
+		if (candidate.empty()) {
+			return candidate;
+		}
+		if (candidate > bound) {
+			bound = std::move(candidate);
+		}
+	}
+	return bound;
+}
+
+// True if a capture's key order is the comparison order of its column: text captures of VARCHAR columns, integer
+// encodings of integer columns and dates of DATE columns
+static bool IsKeyOrdered(level_pivot::CaptureEncoding encoding, const LogicalType &type) {
+	switch (encoding) {
+	case level_pivot::CaptureEncoding::TEXT:
+		return type.id() == LogicalTypeId::VARCHAR;
+	case level_pivot::CaptureEncoding::DATE:
+		return type.id() == LogicalTypeId::DATE;
+	default:
+		return type.IsIntegral();
+	}
+}
+
+// Equality constraints on columns for one branch of an IN list / OR of equalities
+using CaptureEqualities = std::unordered_map<std::string, std::string>;
+
+// Cap on the number of seek ranges produced by IN lists / ORs (beyond this we fall back to a full scan)
+static constexpr idx_t MAX_FILTER_RANGES = 4096;
+
+// Match `column <op> constant` (either side), normalizing op so the column is on the left
+static bool MatchColumnComparison(LogicalGet &get, BoundComparisonExpression &comp, string &col_name, Value &value,
+                                  ExpressionType &comparison) {
+	BoundColumnRefExpression *col_ref = nullptr;
+	BoundConstantExpression *const_ref = nullptr;
+	comparison = comp.type;
+
+	if (comp.left->expression_class == ExpressionClass::BOUND_COLUMN_REF &&
+	    comp.right->expression_class == ExpressionClass::BOUND_CONSTANT) {
+		col_ref = &comp.left->Cast<BoundColumnRefExpression>();
+		const_ref = &comp.right->Cast<BoundConstantExpression>();
+	} else if (comp.right->expression_class == ExpressionClass::BOUND_COLUMN_REF &&
+	           comp.left->expression_class == ExpressionClass::BOUND_CONSTANT) {
+		col_ref = &comp.right->Cast<BoundColumnRefExpression>();
+		const_ref = &comp.left->Cast<BoundConstantExpression>();
+		comparison = FlipComparisonExpression(comparison);
+	}
+
+	if (!col_ref || !const_ref || const_ref->value.IsNull()) {
+		return false;
+	}
+	if (!GetFilterColumnName(get, *col_ref, col_name)) {
+		return false;
+	}
+	value = const_ref->value;
+	return true;
+}
+
+// Key form of a filter constant on col_name. Typed captures are compared by their encoded bytes, other columns by
+// text. Returns false if the constant doesn't fit the capture's encoding; the filter then isn't used for seeking.
+static bool FilterKeyValue(const level_pivot::KeyPattern &pattern, const string &col_name, const Value &value,
+                           string &out) {
+	auto capture_idx = pattern.capture_index(col_name);
+	if (capture_idx < 0) {
+		out = value.ToString();
+		return true;
+	}
+	return TryEncodeCapture(pattern.capture_encoding(capture_idx), value, out);
+}
+
+// Equalities implied by one OR branch: a single `col = const` or an AND of them. Other terms are
+// ignored, which only widens the branch - the post-filter still applies them.
+static CaptureEqualities ExtractBranchEqualities(LogicalGet &get, const level_pivot::KeyPattern &pattern,
+                                                 Expression &expr) {
+	CaptureEqualities result;
+	string col_name;
+	Value value;
+	ExpressionType comparison;
+	string key_value;
+	if (expr.expression_class == ExpressionClass::BOUND_COMPARISON) {
+		if (MatchColumnComparison(get, expr.Cast<BoundComparisonExpression>(), col_name, value, comparison) &&
+		    comparison == ExpressionType::COMPARE_EQUAL && FilterKeyValue(pattern, col_name, value, key_value)) {
+			result[col_name] = std::move(key_value);
+		}
+	} else if (expr.type == ExpressionType::CONJUNCTION_AND) {
+		for (auto &child : expr.Cast<BoundConjunctionExpression>().children) {
+			for (auto &kv : ExtractBranchEqualities(get, pattern, *child)) {
+				result[kv.first] = kv.second;
+			}
+		}
+	}
+	return result;
+}
+
+// AND a disjunction into the current alternatives: every alternative is combined with every branch
+static void ExpandAlternatives(vector<CaptureEqualities> &alternatives, const vector<CaptureEqualities> &branches) {
+	if (branches.empty() || alternatives.size() * branches.size() > MAX_FILTER_RANGES) {
+		return;
+	}
+	vector<CaptureEqualities> result;
+	result.reserve(alternatives.size() * branches.size());
+	for (auto &alternative : alternatives) {
+		for (auto &branch : branches) {
+			auto merged = alternative;
+			for (auto &kv : branch) {
+				merged[kv.first] = kv.second;
+			}
+			result.push_back(std::move(merged));
+		}
+	}
+	alternatives = std::move(result);
+}
+
+// Sort ranges by start key and merge overlapping or duplicate ones
+static vector<LevelPivotKeyRange> NormalizeRanges(vector<LevelPivotKeyRange> ranges) {
+	std::sort(ranges.begin(), ranges.end(),
+	          [](const LevelPivotKeyRange &a, const LevelPivotKeyRange &b) { return a.start < b.start; });
+	vector<LevelPivotKeyRange> result;
+	for (auto &range : ranges) {
+		if (!result.empty()) {
+			auto &last = result.back();
+			if (last == range) {
+				continue;
+			}
+			if (last.end.empty() || range.start <= last.end) {
+				if (!last.end.empty() && (range.end.empty() || range.end > last.end)) {
+					last.end = range.end;
+				}
+				// A merged range must read every identity in it
+				last.skip_suffix.clear();
+				last.identities.clear();
+				continue;
+			}
+		}
+		result.push_back(std::move(range));
+	}
+	return result;
+}
+
+// Called during optimization to narrow the scan's key ranges from filters on identity columns.
+// Equality filters on consecutive identity columns (in pattern order) form a seek prefix; a range filter
+// (<, <=, >, >=, BETWEEN) on the next identity column then sets the seek key and the stop key.
+// IN lists and ORs of equalities expand into one prefix per alternative, giving a sorted list of ranges.
+// We leave all filters in place so DuckDB still applies them as a post-filter, which lets the key ranges
+// be a conservative superset of the matching rows.
 static void LevelPivotPushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data,
                                             vector<unique_ptr<Expression>> &filters) {
 	if (!bind_data) {
 		return;
 	}
 	auto &scan_data = bind_data->Cast<LevelPivotScanData>();
-	// Always reset prefix - bind_data may be reused across queries via Copy()
-	scan_data.filter_prefix.clear();
+	// Always reset the ranges - bind_data may be reused across queries via Copy()
+	scan_data.filter_ranges.clear();
 	auto *table_entry = scan_data.table_entry;
-	if (!table_entry || table_entry->GetTableMode() != LevelPivotTableMode::PIVOT) {
+	if (!table_entry || !table_entry->HasKeyPattern()) {
 		return;
 	}
 
@@ -78,66 +321,331 @@ static void LevelPivotPushdownComplexFilter(ClientContext &context, LogicalGet &
 	auto &pattern = parser.pattern();
 	auto &capture_names = pattern.capture_names();
 
-	// Build a map: column_name -> equality_value from the filter expressions
-	std::unordered_map<std::string, std::string> eq_values;
+	// Collect equality alternatives and range bounds from the filter expressions
+	vector<CaptureEqualities> alternatives(1);
+	std::unordered_map<std::string, CaptureBound> lower_bounds;
+	std::unordered_map<std::string, CaptureBound> upper_bounds;
+	string col_name;
+	Value value;
+	ExpressionType comparison;
+	string key_value;
 	for (idx_t i = 0; i < filters.size(); i++) {
-		auto &filter = filters[i];
-		if (filter->expression_class != ExpressionClass::BOUND_COMPARISON) {
-			continue;
+		auto &filter = *filters[i];
+		if (filter.expression_class == ExpressionClass::BOUND_BETWEEN) {
+			auto &between = filter.Cast<BoundBetweenExpression>();
+			if (between.input->expression_class != ExpressionClass::BOUND_COLUMN_REF ||
+			    between.lower->expression_class != ExpressionClass::BOUND_CONSTANT ||
+			    between.upper->expression_class != ExpressionClass::BOUND_CONSTANT) {
+				continue;
+			}
+			auto &lower = between.lower->Cast<BoundConstantExpression>().value;
+			auto &upper = between.upper->Cast<BoundConstantExpression>().value;
+			if (lower.IsNull() || upper.IsNull() ||
+			    !GetFilterColumnName(get, between.input->Cast<BoundColumnRefExpression>(), col_name)) {
+				continue;
+			}
+			if (FilterKeyValue(pattern, col_name, lower, key_value)) {
+				TightenLower(lower_bounds[col_name], key_value);
+			}
+			if (FilterKeyValue(pattern, col_name, upper, key_value)) {
+				TightenUpper(upper_bounds[col_name], key_value);
+			}
+		} else if (filter.type == ExpressionType::COMPARE_IN) {
+			// col IN (c1, c2, ...): children[0] is the column, the rest are the list
+			auto &in_expr = filter.Cast<BoundOperatorExpression>();
+			if (in_expr.children[0]->expression_class != ExpressionClass::BOUND_COLUMN_REF ||
+			    !GetFilterColumnName(get, in_expr.children[0]->Cast<BoundColumnRefExpression>(), col_name)) {
+				continue;
+			}
+			vector<CaptureEqualities> branches;
+			bool all_constant = true;
+			for (idx_t c = 1; c < in_expr.children.size(); c++) {
+				auto &child = *in_expr.children[c];
+				if (child.expression_class != ExpressionClass::BOUND_CONSTANT) {
+					all_constant = false;
+					break;
+				}
+				auto &in_value = child.Cast<BoundConstantExpression>().value;
+				if (!in_value.IsNull() && FilterKeyValue(pattern, col_name, in_value, key_value)) {
+					branches.push_back(CaptureEqualities {{col_name, key_value}});
+				}
+			}
+			if (all_constant) {
+				ExpandAlternatives(alternatives, branches);
+			}
+		} else if (filter.type == ExpressionType::CONJUNCTION_OR) {
+			vector<CaptureEqualities> branches;
+			for (auto &child : filter.Cast<BoundConjunctionExpression>().children) {
+				branches.push_back(ExtractBranchEqualities(get, pattern, *child));
+			}
+			ExpandAlternatives(alternatives, branches);
+		} else if (filter.expression_class == ExpressionClass::BOUND_COMPARISON) {
+			if (!MatchColumnComparison(get, filter.Cast<BoundComparisonExpression>(), col_name, value, comparison) ||
+			    !FilterKeyValue(pattern, col_name, value, key_value)) {
+				continue;
+			}
+			switch (comparison) {
+			case ExpressionType::COMPARE_EQUAL:
+				for (auto &alternative : alternatives) {
+					alternative[col_name] = key_value;
+				}
+				break;
+			case ExpressionType::COMPARE_GREATERTHAN:
+			case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+				TightenLower(lower_bounds[col_name], key_value);
+				break;
+			case ExpressionType::COMPARE_LESSTHAN:
+			case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+				TightenUpper(upper_bounds[col_name], key_value);
+				break;
+			default:
+				break;
+			}
 		}
-		auto &comp = filter->Cast<BoundComparisonExpression>();
-		if (comp.type != ExpressionType::COMPARE_EQUAL) {
-			continue;
+	}
+
+	vector<LevelPivotKeyRange> ranges;
+	for (auto &eq_values : alternatives) {
+		// Build prefix from consecutive identity column equality matches
+		std::vector<std::string> capture_values;
+		for (auto &cap_name : capture_names) {
+			auto it = eq_values.find(cap_name);
+			if (it == eq_values.end()) {
+				break;
+			}
+			capture_values.push_back(it->second);
 		}
 
-		BoundColumnRefExpression *col_ref = nullptr;
-		BoundConstantExpression *const_ref = nullptr;
+		LevelPivotKeyRange range;
+		range.start = parser.build_prefix(capture_values);
+		range.end = PrefixSuccessor(range.start);
+		if (capture_values.size() == capture_names.size() && pattern.captures_before_attr() == capture_names.size()) {
+			// Every identity column pinned and the prefix covers the whole identity: a point lookup
+			range.identities.push_back(capture_values);
+		}
 
-		if (comp.left->expression_class == ExpressionClass::BOUND_COLUMN_REF &&
-		    comp.right->expression_class == ExpressionClass::BOUND_CONSTANT) {
-			col_ref = &comp.left->Cast<BoundColumnRefExpression>();
-			const_ref = &comp.right->Cast<BoundConstantExpression>();
-		} else if (comp.right->expression_class == ExpressionClass::BOUND_COLUMN_REF &&
-		           comp.left->expression_class == ExpressionClass::BOUND_CONSTANT) {
-			col_ref = &comp.right->Cast<BoundColumnRefExpression>();
-			const_ref = &comp.left->Cast<BoundConstantExpression>();
+		// Range bounds on the next capture, when its key order matches the column's comparison order
+		auto next = capture_values.size();
+		auto lower = lower_bounds.find(next < capture_names.size() ? capture_names[next] : string());
+		auto upper = upper_bounds.find(next < capture_names.size() ? capture_names[next] : string());
+		bool has_bounds = lower != lower_bounds.end() || upper != upper_bounds.end();
+		if (has_bounds && next < pattern.captures_before_attr() &&
+		    IsKeyOrdered(pattern.capture_encoding(next), table_entry->GetColumn(capture_names[next]).Type())) {
+			auto base = range.start;
+			if (lower != lower_bounds.end()) {
+				range.start = base + lower->second.value;
+			}
+			if (upper != upper_bounds.end()) {
+				// A fixed-width capture can't be a proper prefix of another value
+				auto fixed_width = pattern.capture_encoding(next) != level_pivot::CaptureEncoding::TEXT;
+				auto bound = fixed_width ? PrefixSuccessor(base + upper->second.value)
+				                         : CaptureUpperBound(base, upper->second.value,
+				                                             pattern.delimiter_after_capture(next));
+				if (!bound.empty() && (range.end.empty() || bound < range.end)) {
+					range.end = std::move(bound);
+				}
+			}
+		} else if (!has_bounds) {
+			// Skip-scan: the next capture is unconstrained but the ones after it are pinned by equality.
+			// The key continuation after that capture is then fixed: delim + value + delim + ...
+			string suffix(pattern.delimiter_after_capture(next));
+			for (auto c = next + 1; c < pattern.captures_before_attr(); c++) {
+				auto it = eq_values.find(capture_names[c]);
+				if (it == eq_values.end()) {
+					break;
+				}
+				suffix += it->second;
+				suffix += pattern.delimiter_after_capture(c);
+			}
+			if (next + 1 < pattern.captures_before_attr() && eq_values.count(capture_names[next + 1])) {
+				range.skip_capture = next;
+				range.skip_suffix = std::move(suffix);
+			}
+		}
+		if (!range.end.empty() && range.start >= range.end) {
+			continue; // contradictory bounds - nothing to read for this alternative
 		}
+		ranges.push_back(std::move(range));
+	}
 
-		if (!col_ref || !const_ref) {
-			continue;
+	auto default_start = parser.build_prefix();
+	ranges = NormalizeRanges(std::move(ranges));
+	if (ranges.empty() || (ranges.size() == 1 && ranges[0].start == default_start &&
+	                       ranges[0].end == PrefixSuccessor(default_start) && ranges[0].skip_suffix.empty())) {
+		// Nothing narrower than the table prefix (or only contradictory bounds) - leave it to the post-filter
+		return;
+	}
+	scan_data.filter_ranges = std::move(ranges);
+}
+
+// Update identity from captures, reusing string buffer capacity
+static inline void UpdateIdentity(std::vector<std::string> &identity, const std::string_view *captures, size_t count) {
+	identity.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		identity[i].assign(captures[i].data(), captures[i].size());
+	}
+}
+
+// Spread parts-1 split keys evenly between lo and hi by interpolating the first 8 bytes after
+// their common prefix. The result only needs to be roughly uniform - callers snap each split to a real key.
+static vector<string> InterpolateKeys(const string &lo, const string &hi, idx_t parts) {
+	vector<string> result;
+	size_t common = 0;
+	while (common < lo.size() && common < hi.size() && lo[common] == hi[common]) {
+		common++;
+	}
+	auto load = [common](const string &key) {
+		uint64_t v = 0;
+		for (size_t i = 0; i < sizeof(uint64_t); i++) {
+			v <<= 8;
+			if (common + i < key.size()) {
+				v |= static_cast<uint8_t>(key[common + i]);
+			}
 		}
-		if (col_ref->binding.table_index != get.table_index) {
-			continue;
+		return v;
+	};
+	uint64_t a = load(lo);
+	uint64_t b = load(hi);
+	if (b <= a || (b - a) / parts == 0) {
+		return result;
+	}
+	uint64_t step = (b - a) / parts;
+	for (idx_t i = 1; i < parts; i++) {
+		uint64_t v = a + step * i;
+		string key = lo.substr(0, common);
+		for (int shift = 56; shift >= 0; shift -= 8) {
+			key.push_back(static_cast<char>((v >> shift) & 0xff));
 		}
-		if (const_ref->value.IsNull()) {
-			continue;
+		result.push_back(std::move(key));
+	}
+	return result;
+}
+
+// Snap a key to the start of the row it belongs to. In pivot mode that is the identity prefix,
+// so every attr key of the row falls on the same side of the split. Raw and packed keys are rows themselves.
+static bool GetRowBoundary(LevelPivotTableEntry &table_entry, std::string_view key, string &boundary) {
+	if (table_entry.GetTableMode() != LevelPivotTableMode::PIVOT) {
+		boundary.assign(key.data(), key.size());
+		return true;
+	}
+	auto &parser = table_entry.GetKeyParser();
+	std::string_view captures[level_pivot::MAX_KEY_CAPTURES];
+	std::string_view attr;
+	if (!parser.parse_fast(key, captures, attr)) {
+		return false;
+	}
+	std::vector<std::string> identity;
+	UpdateIdentity(identity, captures, parser.pattern().capture_count());
+	boundary = parser.build_prefix(identity);
+	return true;
+}
+
+// Split [start, end) into up to max_ranges row-aligned sub-ranges. The number of ranges comes from
+// LevelDB's approximate on-disk size (returned in bytes); split keys are interpolated and then snapped to real rows.
+// Sub-ranges inherit the skip-scan settings of the parent range.
+static vector<LevelPivotKeyRange> PartitionKeyRange(LevelPivotTableEntry &table_entry, const LevelPivotKeyRange &range,
+                                                    idx_t max_ranges, uint64_t &bytes) {
+	vector<LevelPivotKeyRange> result;
+	auto &start = range.start;
+	auto &end = range.end;
+	auto &connection = *table_entry.GetConnection();
+
+	idx_t num_ranges = 1;
+	bool splittable = table_entry.GetTableMode() != LevelPivotTableMode::PIVOT ||
+	                  table_entry.GetKeyParser().pattern().captures_before_attr() ==
+	                      table_entry.GetKeyParser().pattern().capture_count();
+	bytes = connection.approximate_size(start, end);
+	if (max_ranges > 1 && splittable) {
+		num_ranges = MinValue<idx_t>(max_ranges, bytes / MIN_BYTES_PER_RANGE);
+	}
+
+	vector<string> boundaries;
+	if (num_ranges > 1) {
+		auto iter = connection.iterator();
+		if (start.empty()) {
+			iter.seek_to_first();
+		} else {
+			iter.seek(start);
 		}
+		string first_key = iter.valid() && IsBeforeEnd(iter.key_view(), end) ? iter.key() : string();
 
-		// Map from output position through column_ids to actual table column index
-		auto output_idx = col_ref->binding.column_index;
-		auto &col_ids = get.GetColumnIds();
-		if (output_idx >= col_ids.size()) {
-			continue;
+		string last_key;
+		if (end.empty()) {
+			iter.seek_to_last();
+		} else {
+			iter.seek(end);
+			if (iter.valid()) {
+				iter.prev();
+			} else {
+				iter.seek_to_last();
+			}
 		}
-		auto table_col_idx = col_ids[output_idx].GetPrimaryIndex();
-		if (table_col_idx < get.names.size()) {
-			eq_values[get.names[table_col_idx]] = const_ref->value.ToString();
+		if (iter.valid() && iter.key_view() >= start) {
+			last_key = iter.key();
 		}
-	}
 
-	// Build prefix from consecutive identity column equality matches
-	std::vector<std::string> capture_values;
-	for (auto &cap_name : capture_names) {
-		auto it = eq_values.find(cap_name);
-		if (it == eq_values.end()) {
-			break;
+		if (!first_key.empty() && last_key > first_key) {
+			string boundary;
+			for (auto &candidate : InterpolateKeys(first_key, last_key, num_ranges)) {
+				iter.seek(candidate);
+				if (!iter.valid() || !IsBeforeEnd(iter.key_view(), end)) {
+					break;
+				}
+				if (!GetRowBoundary(table_entry, iter.key_view(), boundary)) {
+					continue;
+				}
+				if (boundary <= start || (!boundaries.empty() && boundary <= boundaries.back())) {
+					continue;
+				}
+				boundaries.push_back(boundary);
+			}
 		}
-		capture_values.push_back(it->second);
 	}
 
-	if (!capture_values.empty()) {
-		scan_data.filter_prefix = parser.build_prefix(capture_values);
+	string range_start = start;
+	boundaries.push_back(end);
+	for (auto &boundary : boundaries) {
+		LevelPivotKeyRange sub_range = range;
+		sub_range.start = range_start;
+		sub_range.end = boundary;
+		result.push_back(std::move(sub_range));
+		range_start = boundary;
 	}
+	return result;
+}
+
+// Pivot and packed tables are bounded by the filter-narrowed ranges (set by pushdown_complex_filter during
+// optimization) or the pattern's literal prefix. Raw tables see the whole keyspace.
+static vector<LevelPivotKeyRange> GetScanRanges(const LevelPivotScanData &bind_data) {
+	auto &table_entry = *bind_data.table_entry;
+	vector<LevelPivotKeyRange> result;
+	if (table_entry.HasKeyPattern() && !bind_data.filter_ranges.empty()) {
+		result = bind_data.filter_ranges;
+	} else {
+		LevelPivotKeyRange range;
+		range.start = table_entry.GetKeyPrefix();
+		range.end = PrefixSuccessor(range.start);
+		result.push_back(std::move(range));
+	}
+	// Never read the metadata keys: a range spanning them is split into the parts before and after them. Point
+	// lookups only Get the keys of their identities.
+	vector<LevelPivotKeyRange> user_ranges;
+	for (auto &range : result) {
+		if (!range.identities.empty() || !OverlapsMetadataKeys(range.start, range.end)) {
+			user_ranges.push_back(std::move(range));
+			continue;
+		}
+		if (range.start < METADATA_KEY_PREFIX) {
+			LevelPivotKeyRange before = range;
+			before.end = string(METADATA_KEY_PREFIX);
+			user_ranges.push_back(std::move(before));
+		}
+		if (range.end.empty() || range.end > METADATA_KEY_END) {
+			range.start = std::max(range.start, string(METADATA_KEY_END));
+			user_ranges.push_back(std::move(range));
+		}
+	}
+	return user_ranges;
 }
 
 static unique_ptr<GlobalTableFunctionState> LevelPivotInitGlobal(ClientContext &context,
@@ -145,70 +653,182 @@ static unique_ptr<GlobalTableFunctionState> LevelPivotInitGlobal(ClientContext &
 	auto result = make_uniq<LevelPivotScanGlobalState>();
 	result->column_ids = input.column_ids;
 
-	// Copy filter prefix from bind_data (set by pushdown_complex_filter during optimization)
-	if (input.bind_data) {
-		auto &bind_data = input.bind_data->Cast<LevelPivotScanData>();
-		result->filter_prefix = bind_data.filter_prefix;
+	auto &bind_data = input.bind_data->Cast<LevelPivotScanData>();
+	auto &table_entry = *bind_data.table_entry;
+	result->overlay = LevelPivotTransaction::Get(context, table_entry.ParentCatalog()).GetReadOverlay();
+	result->snapshot = table_entry.GetConnection()->snapshot();
+
+	auto num_threads = static_cast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+	auto max_ranges = num_threads * RANGES_PER_THREAD;
+	auto scan_ranges = GetScanRanges(bind_data);
+	// With at least as many ranges as the threads take, the ranges are handed out as they are. Splitting them, and
+	// sizing each one with approximate_size, would only slow down the start of the scan (e.g. for a long IN list).
+	bool partition = scan_ranges.size() < max_ranges;
+
+	// Group runs of point lookups into batches, spread over the threads but no larger than a chunk
+	idx_t num_points = 0;
+	for (auto &scan_range : scan_ranges) {
+		num_points += scan_range.identities.size();
+	}
+	auto batch_size = MinValue<idx_t>(STANDARD_VECTOR_SIZE, MaxValue<idx_t>(1, (num_points - 1) / max_ranges + 1));
+	for (idx_t i = 0; i < scan_ranges.size(); i++) {
+		auto &scan_range = scan_ranges[i];
+		if (!scan_range.identities.empty()) {
+			// The previous range was a point lookup too, so the last batch is its batch
+			bool extend = i > 0 && !scan_ranges[i - 1].identities.empty() &&
+			              result->ranges.back().identities.size() < batch_size;
+			if (extend) {
+				auto &last = result->ranges.back();
+				last.end = scan_range.end;
+				for (auto &identity : scan_range.identities) {
+					last.identities.push_back(identity);
+				}
+				result->range_weights.back()++;
+			} else {
+				result->ranges.push_back(scan_range);
+				result->range_weights.push_back(1);
+			}
+			result->total_weight++;
+			continue;
+		}
+		if (!partition) {
+			result->ranges.push_back(scan_range);
+			result->range_weights.push_back(1);
+			result->total_weight++;
+			continue;
+		}
+
+		uint64_t bytes = 0;
+		auto sub_ranges = PartitionKeyRange(table_entry, scan_range, max_ranges, bytes);
+		// Spread the range's size evenly over its sub-ranges; +1 so ranges still in the memtable count too
+		auto weight = bytes / sub_ranges.size() + 1;
+		for (auto &range : sub_ranges) {
+			result->ranges.push_back(std::move(range));
+			result->range_weights.push_back(weight);
+			result->total_weight += weight;
+		}
 	}
 
 	return std::move(result);
 }
 
+static unique_ptr<NodeStatistics> LevelPivotCardinality(ClientContext &context, const FunctionData *bind_data_p) {
+	auto &bind_data = bind_data_p->Cast<LevelPivotScanData>();
+	auto ranges = GetScanRanges(bind_data);
+	auto step = (ranges.size() + MAX_ESTIMATED_RANGES - 1) / MAX_ESTIMATED_RANGES;
+	idx_t sampled = 0;
+	idx_t rows = 0;
+	for (idx_t i = 0; i < ranges.size(); i += step) {
+		rows += bind_data.table_entry->EstimateRange(ranges[i].start, ranges[i].end).rows;
+		sampled++;
+	}
+	if (sampled < ranges.size()) {
+		rows = static_cast<idx_t>(static_cast<double>(rows) * static_cast<double>(ranges.size()) /
+		                          static_cast<double>(sampled));
+	}
+	return make_uniq<NodeStatistics>(rows);
+}
+
+static unique_ptr<BaseStatistics> LevelPivotScanStatistics(ClientContext &context, const FunctionData *bind_data_p,
+                                                           column_t column_index) {
+	auto &bind_data = bind_data_p->Cast<LevelPivotScanData>();
+	return bind_data.table_entry->GetStatistics(context, column_index);
+}
+
+static double LevelPivotScanProgress(ClientContext &context, const FunctionData *bind_data,
+                                     const GlobalTableFunctionState *global_state) {
+	auto &gstate = global_state->Cast<LevelPivotScanGlobalState>();
+	if (gstate.total_weight == 0) {
+		return 100.0;
+	}
+	auto completed = static_cast<double>(gstate.completed_weight.load());
+	return MinValue(100.0, 100.0 * completed / static_cast<double>(gstate.total_weight));
+}
+
 static unique_ptr<LocalTableFunctionState> LevelPivotInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
                                                                GlobalTableFunctionState *global_state) {
-	return make_uniq<LevelPivotScanLocalState>();
+	auto &gstate = global_state->Cast<LevelPivotScanGlobalState>();
+	auto result = make_uniq<LevelPivotScanLocalState>();
+	result->overlay = gstate.overlay;
+	result->snapshot = gstate.snapshot.get();
+	return std::move(result);
 }
 
-// Write a string_view directly into a DuckDB output vector (bypasses Value allocation for VARCHAR)
-static inline void WriteStringDirect(Vector &vec, idx_t row, std::string_view sv) {
-	FlatVector::GetData<string_t>(vec)[row] = StringVector::AddString(vec, sv.data(), sv.size());
+// Claim the next unscanned range and position this thread's iterator at its start
+static bool ClaimNextRange(LevelPivotTableEntry &table_entry, LevelPivotScanGlobalState &gstate,
+                           LevelPivotScanLocalState &lstate) {
+	auto idx = gstate.next_range++;
+	if (idx >= gstate.ranges.size()) {
+		return false;
+	}
+	auto &range = gstate.ranges[idx];
+	lstate.range_idx = idx;
+	lstate.range_end = range.end;
+	lstate.range_active = true;
+	lstate.point_identities = range.identities.empty() ? nullptr : &range.identities;
+	if (lstate.point_identities) {
+		return true; // point lookups don't use the iterator
+	}
+	if (!lstate.iterator) {
+		lstate.iterator = std::make_unique<level_pivot::LevelDBIterator>(
+		    table_entry.GetConnection()->iterator(lstate.overlay, lstate.snapshot));
+	}
+	if (range.start.empty()) {
+		lstate.iterator->seek_to_first();
+	} else {
+		lstate.iterator->seek(range.start);
+	}
+	lstate.skip_capture = range.skip_capture;
+	lstate.skip_suffix = range.skip_suffix;
+	if (!range.skip_suffix.empty()) {
+		auto &pattern = table_entry.GetKeyParser().pattern();
+		lstate.skip_delimiter = string(pattern.delimiter_after_capture(range.skip_capture));
+	}
+	return true;
 }
 
-static inline void WriteValueDirect(Vector &vec, idx_t row, std::string_view sv, const LogicalType &type,
-                                    bool is_json = false) {
-	if (is_json) {
-		auto val = JsonStringToTypedValue(sv, type);
-		if (val.IsNull()) {
-			FlatVector::SetNull(vec, row, true);
-		} else if (type.id() == LogicalTypeId::VARCHAR) {
-			auto str = val.ToString();
-			WriteStringDirect(vec, row, str);
-		} else {
-			vec.SetValue(row, val);
-		}
-		return;
-	}
-	if (type.id() == LogicalTypeId::VARCHAR) {
-		WriteStringDirect(vec, row, sv);
+// Position the iterator on the first key that doesn't start with prefix
+static void SeekPastPrefix(level_pivot::LevelDBIterator &iterator, const string &prefix) {
+	auto next = PrefixSuccessor(prefix);
+	if (next.empty()) {
+		// Nothing can follow; exhaust the iterator
+		iterator.seek_to_last();
+		iterator.next();
 	} else {
-		vec.SetValue(row, StringToTypedValue(sv, type));
+		iterator.seek(next);
 	}
 }
 
-// Update identity from captures, reusing string buffer capacity
-static inline void UpdateIdentity(std::vector<std::string> &identity, const std::string_view *captures, size_t count) {
-	identity.resize(count);
-	for (size_t i = 0; i < count; ++i) {
-		identity[i].assign(captures[i].data(), captures[i].size());
+// Skip-scan step for a parsed key. Returns true if the key belongs to an identity that matches the pinned
+// captures. Otherwise seeks to the matching identity of the key's skip-capture value, or past all keys with
+// that value once it has been passed, and returns false so the caller re-reads the iterator.
+static bool SkipScanSeek(LevelPivotScanLocalState &lstate, std::string_view key) {
+	auto &skipped = lstate.captures_buf[lstate.skip_capture];
+	auto group_end = static_cast<size_t>(skipped.data() - key.data()) + skipped.size();
+	auto &target = lstate.skip_target;
+	target.assign(key.data(), group_end);
+	target += lstate.skip_suffix;
+	if (IsWithinPrefix(key, target)) {
+		return true;
 	}
+	if (key < target) {
+		lstate.iterator->seek(target);
+		return false;
+	}
+	// Past the matching identity for this value - jump to the next distinct value
+	target.resize(group_end);
+	target += lstate.skip_delimiter;
+	SeekPastPrefix(*lstate.iterator, target);
+	return false;
 }
 
-static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate,
-                      LevelPivotScanGlobalState &gstate, DataChunk &output, const vector<column_t> &column_ids) {
+// Build the projection-aware column mappings on a thread's first pivot or packed chunk
+static void InitPivotMappings(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate,
+                              const vector<column_t> &column_ids) {
 	auto &parser = table_entry.GetKeyParser();
-	auto &connection = *table_entry.GetConnection();
 	auto &columns = table_entry.GetColumns();
 
 	if (!lstate.initialized) {
-		// Use filter-narrowed prefix if available, otherwise use the full table prefix
-		lstate.prefix = gstate.filter_prefix.empty() ? parser.build_prefix() : gstate.filter_prefix;
-		lstate.iterator = std::make_unique<level_pivot::LevelDBIterator>(connection.iterator());
-		if (lstate.prefix.empty()) {
-			lstate.iterator->seek_to_first();
-		} else {
-			lstate.iterator->seek(lstate.prefix);
-		}
-
 		lstate.num_captures = parser.pattern().capture_count();
 
 		// Build projection-aware column mappings
@@ -229,13 +849,16 @@ static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalStat
 				im.capture_index = capture_idx >= 0 ? static_cast<idx_t>(capture_idx) : 0;
 				im.output_col = i;
 				im.type = col.Type();
+				im.encoding = parser.pattern().capture_encoding(im.capture_index);
 				lstate.identity_mappings.push_back(std::move(im));
 			} else if (std::find(attr_cols.begin(), attr_cols.end(), col_name) != attr_cols.end()) {
 				AttrMapping am;
-				am.name = col_name;
+				am.packed_index = std::find(attr_cols.begin(), attr_cols.end(), col_name) - attr_cols.begin();
+				am.name = table_entry.GetAttrKey(am.packed_index);
 				am.output_col = i;
 				am.type = col.Type();
-				am.is_json = table_entry.IsJsonColumn(col_idx);
+				am.encoding = table_entry.GetValueEncoding(col_idx);
+				lstate.packed_count = MaxValue<size_t>(lstate.packed_count, am.packed_index + 1);
 				lstate.attr_mappings.push_back(std::move(am));
 			}
 		}
@@ -244,10 +867,174 @@ static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalStat
 		std::sort(lstate.attr_mappings.begin(), lstate.attr_mappings.end(),
 		          [](const AttrMapping &a, const AttrMapping &b) { return a.name < b.name; });
 
+		vector<std::string_view> attr_names;
+		for (auto &am : lstate.attr_mappings) {
+			attr_names.push_back(am.name);
+		}
+		table_entry.InitializeAttrDispatch(lstate.attr_dispatch, attr_names);
 		lstate.attr_written.resize(lstate.attr_mappings.size(), false);
+		lstate.point_values.resize(lstate.attr_mappings.size());
+		lstate.packed_fields.resize(lstate.packed_count);
+		lstate.packed_present = make_unsafe_uniq_array<bool>(lstate.packed_count + 1);
+
+		// Seeking needs all of a row's keys to share the bytes before the attr
+		auto &pattern = parser.pattern();
+		lstate.incremental_parse = pattern.captures_before_attr() == pattern.capture_count();
+		lstate.seek_attrs = lstate.incremental_parse &&
+		                    (lstate.attr_mappings.size() + 1) * SEEK_COST_IN_KEYS <= attr_cols.size();
+
+		vector<bool> stage(column_ids.size(), false);
+		for (auto &im : lstate.identity_mappings) {
+			stage[im.output_col] =
+			    im.type.id() != LogicalTypeId::VARCHAR && !IsNativeCaptureType(im.encoding, im.type);
+		}
+		for (auto &am : lstate.attr_mappings) {
+			stage[am.output_col] = NeedsStaging(am.type, am.encoding);
+		}
+		lstate.output_writer.Initialize(stage);
 		lstate.initialized = true;
 	}
+}
 
+// True if any key of the identity exists. Point lookups only use this when none of the projected attrs were found.
+static bool IdentityExists(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate,
+                           const vector<string> &identity) {
+	auto &parser = table_entry.GetKeyParser();
+	auto prefix = parser.build_prefix(identity);
+	if (!lstate.iterator) {
+		lstate.iterator = std::make_unique<level_pivot::LevelDBIterator>(
+		    table_entry.GetConnection()->iterator(lstate.overlay, lstate.snapshot));
+	}
+	for (lstate.iterator->seek(prefix); lstate.iterator->valid(); lstate.iterator->next()) {
+		auto key = lstate.iterator->key_view();
+		if (!IsWithinPrefix(key, prefix)) {
+			return false;
+		}
+		if (parser.parse_fast(key, lstate.captures_buf, lstate.attr_sv) &&
+		    IdentityMatches(identity, lstate.captures_buf, lstate.num_captures)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Write the projected attrs of a packed row to output row `row`
+static void WritePackedRow(LevelPivotScanLocalState &lstate, DataChunk &output, idx_t row, std::string_view key,
+                           std::string_view value) {
+	if (!level_pivot::unpack_row(value, lstate.packed_count, lstate.packed_fields.data(),
+	                             lstate.packed_present.get())) {
+		throw InvalidInputException("Value of key '%s' is not a packed row", string(key));
+	}
+	for (auto &am : lstate.attr_mappings) {
+		if (lstate.packed_present[am.packed_index]) {
+			lstate.output_writer.Write(output, am.output_col, row, lstate.packed_fields[am.packed_index], am.encoding);
+		} else {
+			lstate.output_writer.SetNull(output, am.output_col, row);
+		}
+	}
+}
+
+// Packed point lookups: a row is a single key, so each identity is one Get
+static void PackedPointLookupScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate,
+                                  DataChunk &output) {
+	auto &parser = table_entry.GetKeyParser();
+	auto &connection = *table_entry.GetConnection();
+
+	idx_t count = 0;
+	for (auto &identity : *lstate.point_identities) {
+		auto key = parser.build_prefix(identity);
+		auto value = connection.get(key, lstate.overlay, lstate.snapshot);
+		if (!value) {
+			continue;
+		}
+		for (auto &im : lstate.identity_mappings) {
+			lstate.output_writer.WriteCapture(output, im.output_col, count, identity[im.capture_index], im.encoding);
+		}
+		WritePackedRow(lstate, output, count, key, *value);
+		count++;
+	}
+	lstate.range_active = false;
+
+	lstate.output_writer.Finish(output, count);
+}
+
+// Point lookups: every identity column is pinned, so fetch the projected attr keys directly with Gets (which
+// bloom filters can answer) instead of seeking an iterator. A batch always fits in one chunk.
+static void PointLookupScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate, DataChunk &output,
+                            const vector<column_t> &column_ids) {
+	InitPivotMappings(table_entry, lstate, column_ids);
+	if (table_entry.GetTableMode() == LevelPivotTableMode::PACKED) {
+		PackedPointLookupScan(table_entry, lstate, output);
+		return;
+	}
+	auto &parser = table_entry.GetKeyParser();
+	auto &connection = *table_entry.GetConnection();
+	auto &attr_mappings = lstate.attr_mappings;
+
+	idx_t count = 0;
+	for (auto &identity : *lstate.point_identities) {
+		bool found = false;
+		for (size_t a = 0; a < attr_mappings.size(); ++a) {
+			lstate.point_values[a] = connection.get(parser.build(identity, string(attr_mappings[a].name)),
+			                                        lstate.overlay, lstate.snapshot);
+			found = found || lstate.point_values[a].has_value();
+		}
+		if (!found && !IdentityExists(table_entry, lstate, identity)) {
+			continue;
+		}
+
+		for (auto &im : lstate.identity_mappings) {
+			lstate.output_writer.WriteCapture(output, im.output_col, count, identity[im.capture_index], im.encoding);
+		}
+		for (size_t a = 0; a < attr_mappings.size(); ++a) {
+			auto &value = lstate.point_values[a];
+			if (value) {
+				auto &am = attr_mappings[a];
+				lstate.output_writer.Write(output, am.output_col, count, *value, am.encoding);
+			} else {
+				lstate.output_writer.SetNull(output, attr_mappings[a].output_col, count);
+			}
+		}
+		count++;
+	}
+	lstate.range_active = false;
+
+	lstate.output_writer.Finish(output, count);
+}
+
+// Wide-row mode: the iterator is on the first key of a row. Fetch each projected attr with a seek to its exact
+// key, then leave the iterator on the first key past the row.
+static void SeekRowAttrs(LevelPivotScanLocalState &lstate, DataChunk &output, idx_t row) {
+	auto &iterator = *lstate.iterator;
+	auto key = iterator.key_view();
+	auto attr_offset = static_cast<size_t>(lstate.attr_sv.data() - key.data());
+	auto suffix_offset = attr_offset + lstate.attr_sv.size();
+	lstate.row_prefix.assign(key.data(), attr_offset);
+	lstate.row_suffix.assign(key.data() + suffix_offset, key.size() - suffix_offset);
+
+	auto &target = lstate.attr_key;
+	for (size_t a = 0; a < lstate.attr_mappings.size(); ++a) {
+		auto &am = lstate.attr_mappings[a];
+		target = lstate.row_prefix;
+		target.append(am.name.data(), am.name.size());
+		target += lstate.row_suffix;
+		if (!IsBeforeEnd(target, lstate.range_end)) {
+			continue;
+		}
+		if (!iterator.valid() || iterator.key_view() != target) {
+			iterator.seek(target);
+		}
+		if (iterator.valid() && iterator.key_view() == target) {
+			lstate.output_writer.Write(output, am.output_col, row, iterator.value_view(), am.encoding);
+			lstate.attr_written[a] = true;
+		}
+	}
+	SeekPastPrefix(iterator, lstate.row_prefix);
+}
+
+// Instantiated per concrete key parser (see KeyParser::visit), so per-key parsing is a direct call
+template <typename Parser>
+static void PivotScanKeys(const Parser &parser, LevelPivotScanLocalState &lstate, DataChunk &output) {
 	auto num_captures = lstate.num_captures;
 	auto &attr_mappings = lstate.attr_mappings;
 	auto num_attrs = attr_mappings.size();
@@ -256,27 +1043,28 @@ static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalStat
 	while (lstate.iterator && lstate.iterator->valid()) {
 		std::string_view key_sv = lstate.iterator->key_view();
 
-		if (!IsWithinPrefix(key_sv, lstate.prefix)) {
-			if (!lstate.has_identity) {
-				gstate.done = true;
-				break;
-			}
-			// Finalize last row: set NULLs for unwritten attrs
-			for (size_t a = 0; a < num_attrs; ++a) {
-				if (!lstate.attr_written[a]) {
-					FlatVector::SetNull(output.data[attr_mappings[a].output_col], count, true);
-				}
-			}
-			count++;
-			lstate.has_identity = false;
-			gstate.done = true;
+		if (!IsBeforeEnd(key_sv, lstate.range_end)) {
 			break;
 		}
 
-		// Parse key with zero-alloc fast path
-		if (!parser.parse_fast(key_sv, lstate.captures_buf, lstate.attr_sv)) {
-			lstate.iterator->next();
-			continue;
+		// Keys continuing the current row start with its identity span, so only their attr needs parsing
+		bool same_row =
+		    lstate.has_identity && lstate.incremental_parse && IsWithinPrefix(key_sv, lstate.identity_span);
+		if (same_row) {
+			if (!parser.parse_attr(key_sv, lstate.identity_span.size(), lstate.attr_sv)) {
+				lstate.iterator->next();
+				continue;
+			}
+		} else {
+			// Parse key with zero-alloc fast path
+			if (!parser.parse_fast(key_sv, lstate.captures_buf, lstate.attr_sv)) {
+				lstate.iterator->next();
+				continue;
+			}
+
+			if (!lstate.skip_suffix.empty() && !SkipScanSeek(lstate, key_sv)) {
+				continue;
+			}
 		}
 
 		if (!lstate.has_identity) {
@@ -287,13 +1075,17 @@ static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalStat
 
 			// Write identity columns directly
 			for (auto &im : lstate.identity_mappings) {
-				WriteValueDirect(output.data[im.output_col], count, lstate.captures_buf[im.capture_index], im.type);
+				lstate.output_writer.WriteCapture(output, im.output_col, count, lstate.captures_buf[im.capture_index],
+				                                  im.encoding);
 			}
-		} else if (!IdentityMatches(lstate.current_identity, lstate.captures_buf, num_captures)) {
+			if (lstate.incremental_parse) {
+				lstate.identity_span.assign(key_sv.data(), lstate.attr_sv.data() - key_sv.data());
+			}
+		} else if (!same_row && !IdentityMatches(lstate.current_identity, lstate.captures_buf, num_captures)) {
 			// Identity changed - finalize previous row
 			for (size_t a = 0; a < num_attrs; ++a) {
 				if (!lstate.attr_written[a]) {
-					FlatVector::SetNull(output.data[attr_mappings[a].output_col], count, true);
+					lstate.output_writer.SetNull(output, attr_mappings[a].output_col, count);
 				}
 			}
 			count++;
@@ -309,7 +1101,7 @@ static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalStat
 				// Solution: don't advance iterator, set identity, and return.
 				// The next call to PivotScan will re-parse this key and handle it.
 				lstate.has_identity = false;
-				output.SetCardinality(count);
+				lstate.output_writer.Finish(output, count);
 				return;
 			}
 
@@ -319,57 +1111,115 @@ static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalStat
 
 			// Write identity columns directly
 			for (auto &im : lstate.identity_mappings) {
-				WriteValueDirect(output.data[im.output_col], count, lstate.captures_buf[im.capture_index], im.type);
+				lstate.output_writer.WriteCapture(output, im.output_col, count, lstate.captures_buf[im.capture_index],
+				                                  im.encoding);
+			}
+			if (lstate.incremental_parse) {
+				lstate.identity_span.assign(key_sv.data(), lstate.attr_sv.data() - key_sv.data());
 			}
 		}
 
-		// Find attr in sorted attr_mappings (linear scan, typically 2-5 entries)
-		for (size_t a = 0; a < num_attrs; ++a) {
-			if (attr_mappings[a].name == lstate.attr_sv) {
-				std::string_view val_sv = lstate.iterator->value_view();
-				WriteValueDirect(output.data[attr_mappings[a].output_col], count, val_sv, attr_mappings[a].type,
-				                 attr_mappings[a].is_json);
-				lstate.attr_written[a] = true;
-				break;
-			}
+		if (lstate.seek_attrs) {
+			// Every key reaching this point starts a row
+			SeekRowAttrs(lstate, output, count);
+			continue;
+		}
+
+		// Match the key's attr to its projected column
+		auto a = lstate.attr_dispatch.Find(lstate.attr_sv);
+		if (a != DConstants::INVALID_INDEX) {
+			std::string_view val_sv = lstate.iterator->value_view();
+			auto &am = attr_mappings[a];
+			lstate.output_writer.Write(output, am.output_col, count, val_sv, am.encoding);
+			lstate.attr_written[a] = true;
 		}
 
 		lstate.iterator->next();
 	}
 
-	// Iterator exhausted - finalize last row if any
+	// Range exhausted - finalize last row if any
 	if (lstate.has_identity) {
 		for (size_t a = 0; a < num_attrs; ++a) {
 			if (!lstate.attr_written[a]) {
-				FlatVector::SetNull(output.data[attr_mappings[a].output_col], count, true);
+				lstate.output_writer.SetNull(output, attr_mappings[a].output_col, count);
 			}
 		}
 		count++;
 		lstate.has_identity = false;
-		gstate.done = true;
 	}
+	lstate.range_active = false;
+
+	lstate.output_writer.Finish(output, count);
+}
+
+static void PivotScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate, DataChunk &output,
+                      const vector<column_t> &column_ids) {
+	InitPivotMappings(table_entry, lstate, column_ids);
+	table_entry.GetKeyParser().visit([&](const auto &parser) { PivotScanKeys(parser, lstate, output); });
+}
+
+// Packed mode: every key is a whole row, so a chunk is full after STANDARD_VECTOR_SIZE matching keys
+template <typename Parser>
+static void PackedScanKeys(const Parser &parser, LevelPivotScanLocalState &lstate, DataChunk &output) {
+	idx_t count = 0;
+	while (count < STANDARD_VECTOR_SIZE && lstate.iterator->valid()) {
+		std::string_view key_sv = lstate.iterator->key_view();
+		if (!IsBeforeEnd(key_sv, lstate.range_end)) {
+			lstate.range_active = false;
+			break;
+		}
+		if (!parser.parse_fast(key_sv, lstate.captures_buf, lstate.attr_sv)) {
+			lstate.iterator->next();
+			continue;
+		}
+		if (!lstate.skip_suffix.empty() && !SkipScanSeek(lstate, key_sv)) {
+			continue;
+		}
 
-	if (!lstate.iterator || !lstate.iterator->valid()) {
-		gstate.done = true;
+		for (auto &im : lstate.identity_mappings) {
+			lstate.output_writer.WriteCapture(output, im.output_col, count, lstate.captures_buf[im.capture_index],
+			                                  im.encoding);
+		}
+		WritePackedRow(lstate, output, count, key_sv, lstate.iterator->value_view());
+		count++;
+		lstate.iterator->next();
+	}
+	if (!lstate.iterator->valid()) {
+		lstate.range_active = false;
 	}
 
-	output.SetCardinality(count);
+	lstate.output_writer.Finish(output, count);
 }
 
-static void RawScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate,
-                    LevelPivotScanGlobalState &gstate, DataChunk &output, const vector<column_t> &column_ids) {
-	auto &connection = *table_entry.GetConnection();
+static void PackedScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate, DataChunk &output,
+                       const vector<column_t> &column_ids) {
+	InitPivotMappings(table_entry, lstate, column_ids);
+	table_entry.GetKeyParser().visit([&](const auto &parser) { PackedScanKeys(parser, lstate, output); });
+}
+
+static void RawScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState &lstate, DataChunk &output,
+                    const vector<column_t> &column_ids) {
 	auto &columns = table_entry.GetColumns();
 
 	if (!lstate.initialized) {
-		lstate.iterator = std::make_unique<level_pivot::LevelDBIterator>(connection.iterator());
-		lstate.iterator->seek_to_first();
+		vector<bool> stage(column_ids.size(), false);
+		for (idx_t i = 0; i < column_ids.size(); i++) {
+			auto col_idx = column_ids[i];
+			if (col_idx == 0 || col_idx == 1) {
+				auto &type = columns.GetColumn(LogicalIndex(col_idx)).Type();
+				stage[i] = NeedsStaging(type, table_entry.GetValueEncoding(col_idx));
+			}
+		}
+		lstate.output_writer.Initialize(stage);
 		lstate.initialized = true;
 	}
 
 	idx_t count = 0;
-	while (count < STANDARD_VECTOR_SIZE && lstate.iterator && lstate.iterator->valid()) {
+	while (count < STANDARD_VECTOR_SIZE && lstate.iterator->valid()) {
 		std::string_view key_sv = lstate.iterator->key_view();
+		if (!IsBeforeEnd(key_sv, lstate.range_end)) {
+			break;
+		}
 		std::string_view val_sv = lstate.iterator->value_view();
 
 		for (idx_t i = 0; i < column_ids.size(); i++) {
@@ -377,23 +1227,21 @@ static void RawScan(LevelPivotTableEntry &table_entry, LevelPivotScanLocalState
 			if (col_idx == COLUMN_IDENTIFIER_ROW_ID) {
 				continue;
 			}
-			auto &col_type = columns.GetColumn(LogicalIndex(col_idx)).Type();
-			bool is_json = table_entry.IsJsonColumn(col_idx);
 			if (col_idx == 0) {
-				WriteValueDirect(output.data[i], count, key_sv, col_type);
+				lstate.output_writer.Write(output, i, count, key_sv);
 			} else if (col_idx == 1) {
-				WriteValueDirect(output.data[i], count, val_sv, col_type, is_json);
+				lstate.output_writer.Write(output, i, count, val_sv, table_entry.GetValueEncoding(col_idx));
 			}
 		}
 		count++;
 		lstate.iterator->next();
 	}
 
-	if (!lstate.iterator || !lstate.iterator->valid()) {
-		gstate.done = true;
+	if (count < STANDARD_VECTOR_SIZE) {
+		lstate.range_active = false;
 	}
 
-	output.SetCardinality(count);
+	lstate.output_writer.Finish(output, count);
 }
 
 static void LevelPivotScanFunc(ClientContext &context, TableFunctionInput &data, DataChunk &output) {
@@ -401,19 +1249,38 @@ static void LevelPivotScanFunc(ClientContext &context, TableFunctionInput &data,
 	auto &gstate = data.global_state->Cast<LevelPivotScanGlobalState>();
 	auto &lstate = data.local_state->Cast<LevelPivotScanLocalState>();
 	auto &table_entry = *bind_data.table_entry;
+	auto &column_ids = gstate.column_ids;
 
-	if (gstate.done) {
-		output.SetCardinality(0);
-		return;
+	// Each chunk comes from a single range (it is the batch index). Keep claiming ranges until one yields rows.
+	while (true) {
+		if (!lstate.range_active && !ClaimNextRange(table_entry, gstate, lstate)) {
+			output.SetCardinality(0);
+			return;
+		}
+		if (lstate.point_identities) {
+			PointLookupScan(table_entry, lstate, output, column_ids);
+		} else if (table_entry.GetTableMode() == LevelPivotTableMode::PIVOT) {
+			PivotScan(table_entry, lstate, output, column_ids);
+		} else if (table_entry.GetTableMode() == LevelPivotTableMode::PACKED) {
+			PackedScan(table_entry, lstate, output, column_ids);
+		} else {
+			RawScan(table_entry, lstate, output, column_ids);
+		}
+		if (!lstate.range_active) {
+			gstate.completed_weight += gstate.range_weights[lstate.range_idx];
+		}
+		if (output.size() > 0) {
+			return;
+		}
 	}
+}
 
-	auto &column_ids = gstate.column_ids;
-
-	if (table_entry.GetTableMode() == LevelPivotTableMode::PIVOT) {
-		PivotScan(table_entry, lstate, gstate, output, column_ids);
-	} else {
-		RawScan(table_entry, lstate, gstate, output, column_ids);
+static OperatorPartitionData LevelPivotGetPartitionData(ClientContext &context, TableFunctionGetPartitionInput &input) {
+	if (input.partition_info.RequiresPartitionColumns()) {
+		throw InternalException("LevelPivot scan does not support partition columns");
 	}
+	auto &lstate = input.local_state->Cast<LevelPivotScanLocalState>();
+	return OperatorPartitionData(lstate.range_idx);
 }
 
 TableFunction LevelPivotScanFunction() {
@@ -423,6 +1290,10 @@ TableFunction LevelPivotScanFunction() {
 	func.projection_pushdown = true;
 	func.filter_pushdown = false;
 	func.pushdown_complex_filter = LevelPivotPushdownComplexFilter;
+	func.get_partition_data = LevelPivotGetPartitionData;
+	func.cardinality = LevelPivotCardinality;
+	func.statistics = LevelPivotScanStatistics;
+	func.table_scan_progress = LevelPivotScanProgress;
 	return func;
 }
 
@@ -2,6 +2,7 @@
 #include "level_pivot_sink_helpers.hpp"
 #include "level_pivot_utils.hpp"
 #include "key_parser.hpp"
+#include <algorithm>
 
 namespace duckdb {
 
@@ -12,19 +13,64 @@ LevelPivotUpdate::LevelPivotUpdate(PhysicalPlan &plan, vector<LogicalType> types
 }
 
 unique_ptr<GlobalSinkState> LevelPivotUpdate::GetGlobalSinkState(ClientContext &context) const {
-	return make_uniq<LevelPivotSinkGlobalState>();
+	return make_uniq<LevelPivotSinkGlobalState>(context, table);
+}
+
+unique_ptr<LocalSinkState> LevelPivotUpdate::GetLocalSinkState(ExecutionContext &context) const {
+	return make_uniq<LevelPivotSinkLocalState>(context, table);
 }
 
 SinkResultType LevelPivotUpdate::Sink(ExecutionContext &context, DataChunk &chunk, OperatorSinkInput &input) const {
-	auto &gstate = input.global_state.Cast<LevelPivotSinkGlobalState>();
+	auto &lstate = input.local_state.Cast<LevelPivotSinkLocalState>();
 	auto ctx = GetSinkContext(context, table);
+	auto &writes = lstate.writes;
+
+	if (ctx.table.GetTableMode() == LevelPivotTableMode::PACKED) {
+		// Read-modify-write each row's single key
+		auto &parser = ctx.table.GetKeyParser();
+		auto &table_columns = ctx.table.GetColumns();
+		auto &attr_cols = ctx.table.GetAttrColumns();
+		auto &identity_encodings = ctx.table.GetIdentityEncodings();
+		idx_t num_update_cols = this->columns.size();
+		idx_t row_id_offset = chunk.ColumnCount() - ctx.table.GetRowIdColumns().size();
+
+		// Packed field of each updated column
+		vector<idx_t> packed_indexes;
+		for (idx_t i = 0; i < num_update_cols; i++) {
+			auto &col_name = table_columns.GetColumn(PhysicalIndex(this->columns[i].index)).Name();
+			auto it = std::find(attr_cols.begin(), attr_cols.end(), col_name);
+			if (it == attr_cols.end()) {
+				throw NotImplementedException("Updating identity columns is not yet supported");
+			}
+			packed_indexes.push_back(it - attr_cols.begin());
+		}
 
-	if (ctx.table.GetTableMode() == LevelPivotTableMode::PIVOT) {
+		PackedRowBuilder packed_row(attr_cols.size());
+		std::vector<std::string> identity_values;
+		for (idx_t row = 0; row < chunk.size(); row++) {
+			ExtractIdentityValues(identity_values, chunk, row, row_id_offset, identity_encodings);
+			auto key = parser.build_prefix(identity_values);
+			auto existing = ctx.connection.get(key, ctx.txn.GetReadOverlay());
+			if (!existing) {
+				continue;
+			}
+			if (!packed_row.Load(*existing)) {
+				throw InvalidInputException("Value of key '%s' is not a packed row", key);
+			}
+			for (idx_t i = 0; i < num_update_cols; i++) {
+				auto &col = table_columns.GetColumn(PhysicalIndex(this->columns[i].index));
+				packed_row.Set(packed_indexes[i], chunk.data[i].GetValue(row), col.Type(),
+				               ctx.table.GetValueEncoding(this->columns[i].index));
+			}
+			writes.put(key, packed_row.Pack());
+			lstate.MarkWritten(ctx, key);
+		}
+	} else if (ctx.table.GetTableMode() == LevelPivotTableMode::PIVOT) {
 		auto &parser = ctx.table.GetKeyParser();
 		auto &table_columns = ctx.table.GetColumns();
 		auto &identity_cols = ctx.table.GetIdentityColumns();
+		auto &identity_encodings = ctx.table.GetIdentityEncodings();
 		auto row_id_cols = ctx.table.GetRowIdColumns();
-		auto batch = ctx.connection.create_batch();
 
 		// The child chunk layout (from DuckDB's update projection):
 		// [update_col_0, update_col_1, ..., row_id_col_0, row_id_col_1, ...]
@@ -38,7 +84,7 @@ SinkResultType LevelPivotUpdate::Sink(ExecutionContext &context, DataChunk &chun
 
 		for (idx_t row = 0; row < chunk.size(); row++) {
 			// Extract identity from row_id columns (at end of chunk)
-			ExtractIdentityValues(identity_values, chunk, row, row_id_offset, num_row_id_cols);
+			ExtractIdentityValues(identity_values, chunk, row, row_id_offset, identity_encodings);
 
 			// Process each updated column (at beginning of chunk)
 			for (idx_t i = 0; i < num_update_cols; i++) {
@@ -63,28 +109,20 @@ SinkResultType LevelPivotUpdate::Sink(ExecutionContext &context, DataChunk &chun
 				}
 
 				// It's an attr column - update the specific key
-				std::string key = parser.build(identity_values, col_name);
+				std::string key = parser.build(identity_values, ctx.table.GetAttrKey(col_name));
 				if (new_val.IsNull()) {
-					batch.del(key);
+					writes.del(key);
 				} else {
 					auto table_col_idx = ctx.table.GetColumnIndex(col_name);
-					if (ctx.table.IsJsonColumn(table_col_idx)) {
-						batch.put(key, TypedValueToJsonString(new_val, col.Type()));
-					} else {
-						batch.put(key, new_val.ToString());
-					}
+					writes.put(key, EncodeStoredValue(new_val, col.Type(), ctx.table.GetValueEncoding(table_col_idx)));
 				}
-				ctx.txn.CheckKeyAgainstTables(key, ctx.schema);
+				lstate.MarkWritten(ctx, key);
 			}
 		}
-
-		batch.commit();
-		gstate.row_count += chunk.size();
 	} else {
 		// Raw mode: chunk layout is [update_value, row_id_key]
-		bool val_is_json = ctx.table.IsJsonColumn(1);
+		auto val_encoding = ctx.table.GetValueEncoding(1);
 		auto &val_col_type = ctx.table.GetColumns().GetColumn(LogicalIndex(1)).Type();
-		auto batch = ctx.connection.create_batch();
 		idx_t key_col_idx = chunk.ColumnCount() - 1;
 		for (idx_t row = 0; row < chunk.size(); row++) {
 			auto key_val = chunk.data[key_col_idx].GetValue(row);
@@ -94,24 +132,25 @@ SinkResultType LevelPivotUpdate::Sink(ExecutionContext &context, DataChunk &chun
 			auto val = chunk.data[0].GetValue(row);
 			std::string key = key_val.ToString();
 			if (val.IsNull()) {
-				batch.put(key, "");
-			} else if (val_is_json) {
-				batch.put(key, TypedValueToJsonString(val, val_col_type));
+				writes.put(key, "");
 			} else {
-				batch.put(key, val.ToString());
+				writes.put(key, EncodeStoredValue(val, val_col_type, val_encoding));
 			}
-			ctx.txn.CheckKeyAgainstTables(key, ctx.schema);
+			lstate.MarkWritten(ctx, key);
 		}
-		batch.commit();
-		gstate.row_count += chunk.size();
 	}
+	lstate.FinishChunk(ctx, input.global_state.Cast<LevelPivotSinkGlobalState>(), chunk.size());
 
 	return SinkResultType::NEED_MORE_INPUT;
 }
 
+SinkCombineResultType LevelPivotUpdate::Combine(ExecutionContext &context, OperatorSinkCombineInput &input) const {
+	return CombineSink(input);
+}
+
 SinkFinalizeType LevelPivotUpdate::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
                                             OperatorSinkFinalizeInput &input) const {
-	return SinkFinalizeType::READY;
+	return FinalizeSink(context, table, input);
 }
 
 SourceResultType LevelPivotUpdate::GetData(ExecutionContext &context, DataChunk &chunk,
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "key_pattern.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace level_pivot {
+
+/**
+ * Short key forms of interned attr names. Code n is stored as one byte for the first K codes and two bytes for
+ * the next K * K, over the K byte values that appear in none of the pattern's literals. An attr code therefore
+ * never contains a delimiter and keys still split the same way.
+ */
+class AttrCodec {
+public:
+	explicit AttrCodec(const KeyPattern &pattern) {
+		std::array<bool, 256> used {};
+		for (const auto &segment : pattern.segments()) {
+			if (std::holds_alternative<LiteralSegment>(segment)) {
+				for (char c : std::get<LiteralSegment>(segment).text) {
+					used[static_cast<uint8_t>(c)] = true;
+				}
+			}
+		}
+		rank_.fill(-1);
+		for (int b = 0; b < 256; ++b) {
+			if (!used[b]) {
+				rank_[b] = static_cast<int16_t>(alphabet_.size());
+				alphabet_.push_back(static_cast<char>(b));
+			}
+		}
+	}
+
+	// Number of distinct codes
+	uint32_t capacity() const {
+		auto k = static_cast<uint32_t>(alphabet_.size());
+		return k + k * k;
+	}
+
+	// Key bytes of code, which must be below capacity()
+	std::string encode(uint32_t code) const {
+		auto k = static_cast<uint32_t>(alphabet_.size());
+		if (code < k) {
+			return std::string(1, alphabet_[code]);
+		}
+		code -= k;
+		std::string result(2, '\0');
+		result[0] = alphabet_[code / k];
+		result[1] = alphabet_[code % k];
+		return result;
+	}
+
+	// Code of key bytes produced by encode. Returns false if bytes aren't a code.
+	bool decode(std::string_view bytes, uint32_t &code) const {
+		auto k = static_cast<uint32_t>(alphabet_.size());
+		if (bytes.size() == 1) {
+			auto r = rank_[static_cast<uint8_t>(bytes[0])];
+			code = static_cast<uint32_t>(r);
+			return r >= 0;
+		}
+		if (bytes.size() == 2) {
+			auto hi = rank_[static_cast<uint8_t>(bytes[0])];
+			auto lo = rank_[static_cast<uint8_t>(bytes[1])];
+			code = k + static_cast<uint32_t>(hi) * k + static_cast<uint32_t>(lo);
+			return hi >= 0 && lo >= 0;
+		}
+		return false;
+	}
+
+private:
+	std::vector<char> alphabet_;     // byte values usable in codes, ascending
+	std::array<int16_t, 256> rank_; // byte value -> position in alphabet_ (-1 = not usable)
+};
+
+} // namespace level_pivot
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "key_pattern.hpp"
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace level_pivot {
+
+/**
+ * Conversions between a typed capture's text form (what DuckDB prints and casts from) and the fixed-width,
+ * order-preserving bytes stored in keys. Byte-wise key order equals value order, so ranges of values are
+ * contiguous key ranges.
+ */
+namespace detail {
+
+inline void put_big_endian(uint64_t value, size_t width, std::string &out) {
+	out.resize(width);
+	for (size_t i = width; i-- > 0;) {
+		out[i] = static_cast<char>(value & 0xff);
+		value >>= 8;
+	}
+}
+
+inline uint64_t get_big_endian(std::string_view bytes) {
+	uint64_t value = 0;
+	for (char c : bytes) {
+		value = (value << 8) | static_cast<uint8_t>(c);
+	}
+	return value;
+}
+
+// Parse the whole of text as a decimal integer
+template <typename T>
+bool parse_integer(std::string_view text, T &value) {
+	auto end = text.data() + text.size();
+	auto result = std::from_chars(text.data(), end, value);
+	return result.ec == std::errc() && result.ptr == end;
+}
+
+// YYYY-MM-DD
+inline bool is_iso_date(std::string_view text) {
+	if (text.size() != 10 || text[4] != '-' || text[7] != '-') {
+		return false;
+	}
+	for (size_t i = 0; i < text.size(); ++i) {
+		if (i != 4 && i != 7 && (text[i] < '0' || text[i] > '9')) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace detail
+
+inline bool is_signed_encoding(CaptureEncoding encoding) {
+	return encoding == CaptureEncoding::I32BE || encoding == CaptureEncoding::I64BE;
+}
+
+inline bool is_unsigned_encoding(CaptureEncoding encoding) {
+	return encoding == CaptureEncoding::U32BE || encoding == CaptureEncoding::U64BE;
+}
+
+// Value of I32BE/I64BE key bytes
+inline int64_t decode_signed_capture(std::string_view bytes) {
+	auto value = detail::get_big_endian(bytes);
+	if (bytes.size() == sizeof(int32_t)) {
+		return static_cast<int32_t>(static_cast<uint32_t>(value) ^ 0x80000000u);
+	}
+	return static_cast<int64_t>(value ^ 0x8000000000000000ull);
+}
+
+// Value of U32BE/U64BE key bytes
+inline uint64_t decode_unsigned_capture(std::string_view bytes) {
+	return detail::get_big_endian(bytes);
+}
+
+// Key form of a signed integer capture (I32BE/I64BE) of width bytes; value must fit the width
+inline void encode_signed_capture(int64_t value, size_t width, std::string &out) {
+	detail::put_big_endian(static_cast<uint64_t>(value) ^ (uint64_t(1) << (8 * width - 1)), width, out);
+}
+
+// Key form of an unsigned integer capture (U32BE/U64BE) of width bytes; value must fit the width
+inline void encode_unsigned_capture(uint64_t value, size_t width, std::string &out) {
+	detail::put_big_endian(value, width, out);
+}
+
+/**
+ * Encode a value given as text (a decimal integer, or YYYY-MM-DD for dates) into its key form.
+ * Returns false if the text isn't a valid value of the encoding, e.g. out of range. TEXT is stored as is.
+ */
+inline bool encode_capture(CaptureEncoding encoding, std::string_view text, std::string &out) {
+	auto width = capture_encoding_width(encoding);
+	switch (encoding) {
+	case CaptureEncoding::TEXT:
+		out.assign(text.data(), text.size());
+		return true;
+	case CaptureEncoding::I32BE: {
+		int32_t value;
+		if (!detail::parse_integer(text, value)) {
+			return false;
+		}
+		encode_signed_capture(value, width, out);
+		return true;
+	}
+	case CaptureEncoding::I64BE: {
+		int64_t value;
+		if (!detail::parse_integer(text, value)) {
+			return false;
+		}
+		encode_signed_capture(value, width, out);
+		return true;
+	}
+	case CaptureEncoding::U32BE: {
+		uint32_t value;
+		if (!detail::parse_integer(text, value)) {
+			return false;
+		}
+		encode_unsigned_capture(value, width, out);
+		return true;
+	}
+	case CaptureEncoding::U64BE: {
+		uint64_t value;
+		if (!detail::parse_integer(text, value)) {
+			return false;
+		}
+		encode_unsigned_capture(value, width, out);
+		return true;
+	}
+	case CaptureEncoding::DATE:
+		if (!detail::is_iso_date(text)) {
+			return false;
+		}
+		out.assign(text.data(), text.size());
+		return true;
+	}
+	return false;
+}
+
+// Text form of key bytes produced by encode_capture
+inline void decode_capture(CaptureEncoding encoding, std::string_view bytes, std::string &out) {
+	if (is_signed_encoding(encoding)) {
+		out = std::to_string(decode_signed_capture(bytes));
+	} else if (is_unsigned_encoding(encoding)) {
+		out = std::to_string(decode_unsigned_capture(bytes));
+	} else {
+		out.assign(bytes.data(), bytes.size());
+	}
+}
+
+} // namespace level_pivot
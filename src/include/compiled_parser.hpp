@@ -0,0 +1,118 @@
+#pragma once
+
+#include "key_pattern.hpp"
+#include "simd_parser.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace level_pivot {
+
+/**
+ * Key parser for arbitrary literal/capture sequences, e.g. evt:{tenant}/{day}#{id}.{attr}
+ *
+ * The pattern is compiled once into a flat plan: the literal prefix, then one step per capture or {attr}
+ * holding the literal that terminates it. Parsing walks the plan without allocating, finding each terminator
+ * with the runtime-selected SIMD first-byte search used by SimdKeyParser. Matches the leftmost-terminator
+ * rule of the segment-by-segment parser it replaces.
+ *
+ * Captures with a fixed-width encoding ({ts:i64be}) are taken by length instead, since their bytes may contain
+ * the terminator.
+ */
+class CompiledKeyParser {
+public:
+	explicit CompiledKeyParser(const KeyPattern &pattern) : find_delimiters_(detail::get_find_delimiters()) {
+		const auto &segments = pattern.segments();
+		size_t capture_idx = 0;
+		for (size_t i = 0; i < segments.size(); ++i) {
+			if (std::holds_alternative<LiteralSegment>(segments[i])) {
+				if (i == 0) {
+					prefix_ = std::get<LiteralSegment>(segments[i]).text;
+				}
+				// Other literals are the terminator of the preceding step
+				continue;
+			}
+			Step step;
+			step.is_attr = std::holds_alternative<AttrSegment>(segments[i]);
+			if (!step.is_attr) {
+				step.capture_idx = capture_idx;
+				step.width = capture_encoding_width(pattern.capture_encoding(capture_idx));
+				capture_idx++;
+			}
+			if (i + 1 < segments.size()) {
+				step.terminator = std::get<LiteralSegment>(segments[i + 1]).text;
+			}
+			steps_.push_back(std::move(step));
+		}
+	}
+
+	/**
+	 * Parse into pre-allocated views. Returns false if the key doesn't match the pattern.
+	 */
+	bool parse_fast(std::string_view key, std::string_view *captures, std::string_view &attr) const {
+		if (key.size() < prefix_.size() || key.compare(0, prefix_.size(), prefix_) != 0) {
+			return false;
+		}
+		size_t pos = prefix_.size();
+		for (const auto &step : steps_) {
+			size_t end;
+			if (step.width != 0) {
+				end = pos + step.width;
+				if (end > key.size() || key.compare(end, step.terminator.size(), step.terminator) != 0) {
+					return false;
+				}
+			} else if (!find_terminator(key, pos, step.terminator, end)) {
+				return false;
+			}
+			if (step.is_attr) {
+				attr = key.substr(pos, end - pos);
+			} else {
+				captures[step.capture_idx] = key.substr(pos, end - pos);
+			}
+			pos = end + step.terminator.size();
+		}
+		return pos == key.size();
+	}
+
+	/**
+	 * Locate only the attr of a key whose first identity_len bytes equal those of a key parse_fast accepted.
+	 * Only valid when {attr} is the last variable segment.
+	 */
+	bool parse_attr(std::string_view key, size_t identity_len, std::string_view &attr) const {
+		const auto &step = steps_.back();
+		size_t end;
+		if (!find_terminator(key, identity_len, step.terminator, end) || end + step.terminator.size() != key.size()) {
+			return false;
+		}
+		attr = key.substr(identity_len, end - identity_len);
+		return true;
+	}
+
+private:
+	struct Step {
+		bool is_attr = false;
+		size_t capture_idx = 0;
+		size_t width = 0;       // fixed byte width of an encoded capture (0 = ends at the terminator)
+		std::string terminator; // "" = runs to the end of the key
+	};
+
+	std::string prefix_;
+	std::vector<Step> steps_;
+	detail::FindDelimitersFn find_delimiters_;
+
+	// End of the non-empty variable segment starting at pos: the first occurrence of terminator
+	bool find_terminator(std::string_view key, size_t pos, const std::string &terminator, size_t &end) const {
+		if (terminator.empty()) {
+			end = key.size();
+		} else {
+			size_t count = 0;
+			find_delimiters_(key.data(), key.size(), pos, terminator.data(), terminator.size(), &end, count, 1);
+			if (count == 0) {
+				return false;
+			}
+		}
+		return end > pos;
+	}
+};
+
+} // namespace level_pivot
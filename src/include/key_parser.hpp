@@ -2,12 +2,14 @@
 
 #include "key_pattern.hpp"
 #include "simd_parser.hpp"
+#include "compiled_parser.hpp"
 #include <string>
 #include <string_view>
 #include <vector>
 #include <optional>
 #include <unordered_map>
 #include <memory>
+#include <variant>
 
 namespace level_pivot {
 
@@ -20,6 +22,10 @@ struct ParsedKeyView {
 	}
 };
 
+// Uniform-delimiter parsers specialized for the common capture counts
+using FixedSimdKeyParser = std::variant<SimdKeyParserN<1>, SimdKeyParserN<2>, SimdKeyParserN<3>, SimdKeyParserN<4>,
+                                        SimdKeyParserN<5>, SimdKeyParserN<6>>;
+
 class KeyParser {
 public:
 	explicit KeyParser(const KeyPattern &pattern);
@@ -35,23 +41,50 @@ public:
 	// captures must point to an array with at least pattern().capture_count() elements.
 	bool parse_fast(std::string_view key, std::string_view *captures, std::string_view &attr) const;
 
+	// Incremental parse for keys read in order. The first identity_len bytes of key (everything before the attr)
+	// must equal those of a key already accepted by parse_fast; only the attr is located. Gives the same attr
+	// as parse_fast. Requires pattern().captures_before_attr() == pattern().capture_count().
+	bool parse_attr(std::string_view key, size_t identity_len, std::string_view &attr) const;
+
+	// Calls fn with the concrete parser chosen for this pattern (a SimdKeyParserN, SimdKeyParser or
+	// CompiledKeyParser). Loops over many keys instantiated inside fn call its parse_fast/parse_attr directly,
+	// with no per-key dispatch.
+	template <typename Fn>
+	void visit(Fn &&fn) const {
+		if (fixed_parser_) {
+			std::visit(fn, *fixed_parser_);
+		} else if (simd_parser_) {
+			fn(*simd_parser_);
+		} else {
+			fn(*compiled_parser_);
+		}
+	}
+
 	std::string build(const std::vector<std::string> &capture_values, const std::string &attr_name) const;
 	std::string build(const std::unordered_map<std::string, std::string> &captures, const std::string &attr_name) const;
 
 	std::string build_prefix() const;
 	std::string build_prefix(const std::vector<std::string> &capture_values) const;
 
+	// Bulk-write form of build(): the key bytes before and after {attr} go to head and tail (reused buffers), so
+	// each attr's key is head + attr + tail. Without {attr} the whole key is head. Checks values like build().
+	void build_parts(const std::vector<std::string> &capture_values, std::string &head, std::string &tail) const;
+
 private:
 	KeyPattern pattern_;
 	size_t estimated_key_size_;
 
-	// SIMD parser for uniform delimiter patterns (optional)
+	// SIMD parser for uniform delimiter patterns (optional), specialized when the capture count allows
+	std::optional<FixedSimdKeyParser> fixed_parser_;
 	std::unique_ptr<SimdKeyParser> simd_parser_;
 	std::string simd_prefix_;
 	std::string simd_delimiter_;
+	// Every other pattern
+	std::unique_ptr<CompiledKeyParser> compiled_parser_;
 
+	void check_capture_value(const CaptureSegment &capture, const std::string &value) const;
 	void compute_estimated_key_size();
-	void try_init_simd_parser();
+	void init_parser();
 	std::optional<std::string> try_get_uniform_delimiter() const;
 };
 
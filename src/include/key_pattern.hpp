@@ -6,6 +6,7 @@
 #include <variant>
 #include <optional>
 #include <stdexcept>
+#include <cstdint>
 
 namespace level_pivot {
 
@@ -22,10 +23,21 @@ struct LiteralSegment {
 	}
 };
 
+// How a capture's value is stored in the key. TEXT is the value's text, ending at the next delimiter. The others
+// ({ts:i64be}, {day:date}, ...) are fixed-width and sort in value order: big-endian integers (signed ones with the
+// sign bit flipped) and ISO dates.
+enum class CaptureEncoding : uint8_t { TEXT, I32BE, I64BE, U32BE, U64BE, DATE };
+
+// Encoded width in bytes (0 = variable-width TEXT)
+size_t capture_encoding_width(CaptureEncoding encoding);
+// Name used in patterns ("text", "i32be", ...)
+const char *capture_encoding_name(CaptureEncoding encoding);
+
 struct CaptureSegment {
 	std::string name;
+	CaptureEncoding encoding = CaptureEncoding::TEXT;
 	bool operator==(const CaptureSegment &other) const {
-		return name == other.name;
+		return name == other.name && encoding == other.encoding;
 	}
 };
 
@@ -39,7 +51,8 @@ using PatternSegment = std::variant<LiteralSegment, CaptureSegment, AttrSegment>
 
 class KeyPattern {
 public:
-	explicit KeyPattern(const std::string &pattern);
+	// require_attr = false allows patterns without {attr}, whose keys each hold a whole row (packed tables)
+	explicit KeyPattern(const std::string &pattern, bool require_attr = true);
 
 	const std::string &pattern() const {
 		return pattern_;
@@ -62,20 +75,34 @@ public:
 	size_t capture_count() const {
 		return capture_names_.size();
 	}
+	// Number of captures that appear before {attr} (all of them without {attr}); only these form a contiguous
+	// key prefix
+	size_t captures_before_attr() const {
+		return captures_before_attr_;
+	}
+	CaptureEncoding capture_encoding(size_t capture_idx) const {
+		return capture_encodings_[capture_idx];
+	}
+	// True if any capture has a fixed-width encoding
+	bool has_typed_captures() const;
 	bool has_capture(std::string_view name) const;
 	int capture_index(std::string_view name) const;
+	// Literal that immediately follows the given capture ("" if the capture ends the pattern)
+	std::string_view delimiter_after_capture(size_t capture_idx) const;
 
 private:
 	std::string pattern_;
 	std::vector<PatternSegment> segments_;
 	std::vector<std::string> capture_names_;
+	std::vector<CaptureEncoding> capture_encodings_;
 	std::string literal_prefix_;
 	bool has_attr_ = false;
 	int attr_index_ = -1;
+	size_t captures_before_attr_ = 0;
 
 	void parse(const std::string &pattern);
 	void compute_literal_prefix();
-	void validate() const;
+	void validate(bool require_attr) const;
 };
 
 } // namespace level_pivot
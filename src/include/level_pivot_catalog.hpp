@@ -3,12 +3,14 @@
 #include "duckdb/catalog/catalog.hpp"
 #include "duckdb/common/mutex.hpp"
 #include "level_pivot_storage.hpp"
+#include "level_pivot_utils.hpp"
 #include <memory>
 
 namespace duckdb {
 
 class LevelPivotSchemaEntry;
 class LevelPivotTableEntry;
+enum class LevelPivotTableMode : uint8_t;
 
 class LevelPivotCatalog : public Catalog {
 public:
@@ -48,10 +50,15 @@ public:
 	string GetDBPath() override;
 
 	// Table management (called by level_pivot_create_table function)
+	// Pivot or packed table: the pattern's captures are identity columns, the other columns attrs.
+	// attr_codes interns attr names into short codes in keys (pivot tables only).
 	void CreatePivotTable(const string &table_name, const string &pattern, const vector<string> &column_names,
-	                      const vector<LogicalType> &column_types, const vector<bool> &column_json);
+	                      const vector<LogicalType> &column_types,
+	                      const vector<LevelPivotValueEncoding> &column_encodings, LevelPivotTableMode mode,
+	                      bool attr_codes = false);
 	void CreateRawTable(const string &table_name, const vector<string> &column_names,
-	                    const vector<LogicalType> &column_types, const vector<bool> &column_json);
+	                    const vector<LogicalType> &column_types,
+	                    const vector<LevelPivotValueEncoding> &column_encodings);
 	void DropTable(const string &table_name);
 
 private:
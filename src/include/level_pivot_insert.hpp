@@ -13,10 +13,15 @@ public:
 	                 idx_t estimated_cardinality);
 
 	TableCatalogEntry &table;
+	// Chunk columns of the identity captures (in capture order) and of the attr columns; empty for raw tables
+	vector<idx_t> capture_columns;
+	vector<idx_t> attr_columns;
 
 	// --- Sink interface ---
 	unique_ptr<GlobalSinkState> GetGlobalSinkState(ClientContext &context) const override;
+	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) const override;
 	SinkResultType Sink(ExecutionContext &context, DataChunk &chunk, OperatorSinkInput &input) const override;
+	SinkCombineResultType Combine(ExecutionContext &context, OperatorSinkCombineInput &input) const override;
 	SinkFinalizeType Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
 	                          OperatorSinkFinalizeInput &input) const override;
 
@@ -24,7 +29,7 @@ public:
 		return true;
 	}
 	bool ParallelSink() const override {
-		return false;
+		return true;
 	}
 
 	// --- Source interface ---
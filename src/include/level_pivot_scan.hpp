@@ -1,25 +1,49 @@
 #pragma once
 
 #include "duckdb/function/table_function.hpp"
+#include "duckdb/storage/statistics/node_statistics.hpp"
+#include "level_pivot_storage.hpp"
+#include <atomic>
 
 namespace duckdb {
 
 class LevelPivotTableEntry;
 
+// Half-open key range [start, end). Empty end = unbounded.
+// In pivot mode, range bounds always fall on identity boundaries so a row never spans two ranges.
+struct LevelPivotKeyRange {
+	string start;
+	string end;
+	// Skip-scan (pivot mode): when skip_suffix is set, only identities whose key continues with skip_suffix
+	// right after capture skip_capture are read. The scan seeks to that suffix for each distinct value of
+	// skip_capture, then seeks past the rest of that value's keys.
+	idx_t skip_capture = 0;
+	string skip_suffix;
+	// Point lookups (pivot mode, every capture pinned): when set, each identity's attr keys are fetched with
+	// Gets instead of iterating. start/end still span all of them.
+	vector<vector<string>> identities;
+
+	bool operator==(const LevelPivotKeyRange &other) const {
+		return start == other.start && end == other.end && skip_capture == other.skip_capture &&
+		       skip_suffix == other.skip_suffix && identities == other.identities;
+	}
+};
+
 struct LevelPivotScanData : public TableFunctionData {
 	LevelPivotTableEntry *table_entry;
-	string filter_prefix; // Narrowed prefix from pushdown_complex_filter (empty = use default)
+	// Sorted, non-overlapping key ranges narrowed by pushdown_complex_filter (empty = use the table's prefix)
+	vector<LevelPivotKeyRange> filter_ranges;
 
 	unique_ptr<FunctionData> Copy() const override {
 		auto copy = make_uniq<LevelPivotScanData>();
 		copy->table_entry = table_entry;
-		copy->filter_prefix = filter_prefix;
+		copy->filter_ranges = filter_ranges;
 		return std::move(copy);
 	}
 
 	bool Equals(const FunctionData &other_p) const override {
 		auto &other = other_p.Cast<LevelPivotScanData>();
-		return table_entry == other.table_entry && filter_prefix == other.filter_prefix;
+		return table_entry == other.table_entry && filter_ranges == other.filter_ranges;
 	}
 
 	bool SupportStatementCache() const override {
@@ -30,11 +54,19 @@ struct LevelPivotScanData : public TableFunctionData {
 struct LevelPivotScanGlobalState : public GlobalTableFunctionState {
 	explicit LevelPivotScanGlobalState();
 	idx_t MaxThreads() const override {
-		return 1;
+		return ranges.size();
 	}
-	bool done = false;
 	vector<column_t> column_ids;
-	string filter_prefix; // Narrowed prefix from filter pushdown (empty = use default)
+	vector<LevelPivotKeyRange> ranges; // sorted, non-overlapping; each is scanned by one thread at a time
+	std::atomic<idx_t> next_range;
+	// Progress tracking: approximate size of each range, and the summed size of the ranges finished so far
+	vector<uint64_t> range_weights;
+	uint64_t total_weight = 0;
+	std::atomic<uint64_t> completed_weight;
+	// The transaction's buffered writes, merged over what the scan reads (nullptr = none)
+	const level_pivot::LevelDBWriteSet *overlay = nullptr;
+	// Every thread reads this one state, so a commit during the scan can't show in some ranges but not others
+	std::unique_ptr<level_pivot::LevelDBSnapshot> snapshot;
 };
 
 TableFunction LevelPivotScanFunction();
@@ -5,11 +5,80 @@
 #include "level_pivot_transaction.hpp"
 #include "level_pivot_storage.hpp"
 #include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/main/client_context.hpp"
+#include <atomic>
 
 namespace duckdb {
 
+// Where a sink thread's writes go. In an explicit transaction they are buffered in a write set, which later
+// statements read through and the transaction applies at COMMIT. An autocommit statement is the whole transaction and
+// nothing reads its writes back, so they go straight into a LevelDB write batch, written once at Finalize (or, with
+// async writes, handed to the background writer whenever it fills up).
+struct LevelPivotSinkWrites {
+	LevelPivotSinkWrites(level_pivot::LevelDBConnection &connection, bool buffered)
+	    : buffered(buffered), batch(buffered ? level_pivot::LevelDBWriteBatch(nullptr) : connection.create_batch()) {
+	}
+
+	void put(std::string_view key, std::string_view value) {
+		if (buffered) {
+			set.put(key, value);
+		} else {
+			batch.put(key, value);
+		}
+	}
+	void del(std::string_view key) {
+		if (buffered) {
+			set.del(key);
+		} else {
+			batch.del(key);
+		}
+	}
+	size_t bytes() const {
+		return buffered ? set.bytes() : batch.bytes();
+	}
+	void Merge(LevelPivotSinkWrites &&other) {
+		if (buffered) {
+			set.merge(std::move(other.set));
+		} else {
+			batch.append(std::move(other.batch));
+		}
+	}
+
+	bool buffered;
+	level_pivot::LevelDBWriteSet set;
+	level_pivot::LevelDBWriteBatch batch;
+};
+
+// Whether the running statement's writes are buffered in its transaction (see LevelPivotSinkWrites)
+inline bool IsBufferedStatement(ClientContext &context) {
+	return !context.transaction.IsAutoCommit();
+}
+
+// Throw if pending more bytes of writes would take the transaction past the connection's max_transaction_size.
+// An autocommit statement buffers nothing in its transaction, so this bounds the statement's own write batch.
+inline void CheckTransactionSize(LevelPivotTransaction &txn, level_pivot::LevelDBConnection &connection,
+                                 size_t pending) {
+	auto limit = connection.max_transaction_size();
+	if (txn.GetBufferedBytes() + pending > limit) {
+		throw TransactionException("Transaction writes exceed max_transaction_size (%llu bytes); commit in smaller "
+		                           "transactions or statements, or raise the ATTACH option",
+		                           static_cast<unsigned long long>(limit));
+	}
+}
+
 struct LevelPivotSinkGlobalState : public GlobalSinkState {
+	LevelPivotSinkGlobalState(ClientContext &context, TableCatalogEntry &table)
+	    : writes(*table.Cast<LevelPivotTableEntry>().GetConnection(), IsBufferedStatement(context)) {
+	}
+
+	mutex lock;
+	LevelPivotSinkWrites writes; // the statement's writes, gathered from the threads at Combine
+	LevelPivotDirtyTables dirty;
 	idx_t row_count = 0;
+	//! Bytes of writes held by all threads so far, checked against max_transaction_size as they grow
+	std::atomic<size_t> pending_bytes {0};
+	//! Batches the threads handed to the background writer, gathered at Combine
+	vector<std::shared_ptr<level_pivot::LevelDBPendingWrite>> handed_off;
 };
 
 struct SinkContext {
@@ -23,11 +92,136 @@ inline SinkContext GetSinkContext(ExecutionContext &context, TableCatalogEntry &
 	auto &lp_table = table_ref.Cast<LevelPivotTableEntry>();
 	auto &connection = *lp_table.GetConnection();
 	auto &catalog = lp_table.ParentCatalog().Cast<LevelPivotCatalog>();
-	auto &txn = Transaction::Get(context.client, catalog).Cast<LevelPivotTransaction>();
+	auto &txn = LevelPivotTransaction::Get(context.client, catalog);
 	auto &schema = catalog.GetMainSchema();
 	return {lp_table, connection, txn, schema};
 }
 
+// Per-thread state of the insert, update and delete sinks, gathered into the global state at Combine
+struct LevelPivotSinkLocalState : public LocalSinkState {
+	LevelPivotSinkLocalState(ExecutionContext &context, TableCatalogEntry &table)
+	    : writes(*table.Cast<LevelPivotTableEntry>().GetConnection(), IsBufferedStatement(context.client)) {
+	}
+
+	//! With async writes, an autocommit statement's batch goes to the background writer once it holds this many bytes
+	static constexpr size_t ASYNC_HANDOFF_BYTES = static_cast<size_t>(4) << 20;
+
+	LevelPivotSinkWrites writes;
+	LevelPivotDirtyTables dirty;
+	idx_t row_count = 0;
+	size_t counted_bytes = 0; // this thread's share of the global pending_bytes
+	vector<std::shared_ptr<level_pivot::LevelDBPendingWrite>> handed_off;
+	bool wrote = false;
+	vector<reference<LevelPivotTableEntry>> dirty_candidates; // tables the written keys may still turn dirty
+
+	// Mark the tables a written key belongs to. The first write marks the target table and every raw table at once;
+	// later keys are only parsed by the other tables sharing the target's key range, until each of them matched.
+	void MarkWritten(SinkContext &ctx, std::string_view key) {
+		if (!wrote) {
+			dirty.MarkWriter(ctx.table, ctx.schema, dirty_candidates);
+			wrote = true;
+		}
+		if (!dirty_candidates.empty()) {
+			dirty.CheckKey(key, dirty_candidates);
+		}
+	}
+
+	// Called after each input chunk. A full autocommit batch is handed off, so the thread encodes the next chunks
+	// while LevelDB writes it. The statement's writes held in memory, summed over its threads, are checked against
+	// the transaction's size limit as they grow.
+	void FinishChunk(SinkContext &ctx, LevelPivotSinkGlobalState &gstate, idx_t count) {
+		row_count += count;
+		if (!writes.buffered && ctx.connection.async_writes() && writes.batch.bytes() >= ASYNC_HANDOFF_BYTES) {
+			handed_off.push_back(writes.batch.commit_async());
+		}
+		auto bytes = writes.bytes();
+		size_t total;
+		if (bytes >= counted_bytes) {
+			total = gstate.pending_bytes += bytes - counted_bytes;
+		} else {
+			// Overwrites in a write set can shrink it
+			total = gstate.pending_bytes -= counted_bytes - bytes;
+		}
+		counted_bytes = bytes;
+		CheckTransactionSize(ctx.txn, ctx.connection, total);
+	}
+
+	void Combine(LevelPivotSinkGlobalState &gstate) {
+		lock_guard<mutex> guard(gstate.lock);
+		gstate.writes.Merge(std::move(writes));
+		gstate.dirty.Merge(dirty);
+		gstate.row_count += row_count;
+		for (auto &pending : handed_off) {
+			gstate.handed_off.push_back(std::move(pending));
+		}
+	}
+};
+
+// A packed row being written: the stored form of each attr column, in declaration order
+struct PackedRowBuilder {
+	explicit PackedRowBuilder(idx_t count)
+	    : stored(count), fields(count), present(make_unsafe_uniq_array<bool>(count + 1)) {
+		std::fill(present.get(), present.get() + count, false);
+	}
+
+	void Set(idx_t idx, const Value &val, const LogicalType &type, LevelPivotValueEncoding encoding) {
+		if (val.IsNull()) {
+			SetNull(idx);
+		} else {
+			SetStored(idx, EncodeStoredValue(val, type, encoding));
+		}
+	}
+	void SetStored(idx_t idx, std::string_view value) {
+		stored[idx].assign(value.data(), value.size());
+		fields[idx] = stored[idx];
+		present[idx] = true;
+	}
+	void SetNull(idx_t idx) {
+		present[idx] = false;
+	}
+
+	// Load the fields of an existing packed value, which must outlive the builder's use of them
+	bool Load(std::string_view value) {
+		return level_pivot::unpack_row(value, fields.size(), fields.data(), present.get());
+	}
+
+	const string &Pack() {
+		level_pivot::pack_row(fields.data(), present.get(), fields.size(), packed);
+		return packed;
+	}
+
+	vector<string> stored;
+	vector<std::string_view> fields;
+	unsafe_unique_array<bool> present;
+	string packed;
+};
+
+inline SinkCombineResultType CombineSink(OperatorSinkCombineInput &input) {
+	auto &gstate = input.global_state.Cast<LevelPivotSinkGlobalState>();
+	input.local_state.Cast<LevelPivotSinkLocalState>().Combine(gstate);
+	return SinkCombineResultType::FINISHED;
+}
+
+// Scans of this statement are done, so its writes can join the transaction's, or be written (autocommit)
+inline SinkFinalizeType FinalizeSink(ClientContext &context, TableCatalogEntry &table_ref,
+                                     OperatorSinkFinalizeInput &input) {
+	auto &gstate = input.global_state.Cast<LevelPivotSinkGlobalState>();
+	auto &catalog = table_ref.ParentCatalog().Cast<LevelPivotCatalog>();
+	auto &txn = LevelPivotTransaction::Get(context, catalog);
+	CheckTransactionSize(txn, *catalog.GetConnection(), gstate.writes.bytes());
+	if (gstate.writes.buffered) {
+		txn.MergeWrites(std::move(gstate.writes.set));
+		txn.MergeDirtyTables(gstate.dirty);
+	} else {
+		// A failed hand-off fails the statement before the rest of its writes go out
+		for (auto &pending : gstate.handed_off) {
+			catalog.GetConnection()->wait_for_write(*pending);
+		}
+		gstate.dirty.Commit(catalog, gstate.writes.batch);
+	}
+	return SinkFinalizeType::READY;
+}
+
 inline SourceResultType EmitRowCount(GlobalSinkState &sink_state, DataChunk &chunk) {
 	auto &gstate = sink_state.Cast<LevelPivotSinkGlobalState>();
 	chunk.SetCardinality(1);
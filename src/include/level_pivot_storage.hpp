@@ -1,15 +1,26 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <string_view>
 #include <memory>
 #include <optional>
 #include <stdexcept>
+#include <cstdint>
 
 namespace leveldb {
 class DB;
 class Iterator;
+class Snapshot;
 class WriteBatch;
+class Cache;
+class FilterPolicy;
+class Status;
 } // namespace leveldb
 
 namespace level_pivot {
@@ -20,17 +31,90 @@ public:
 	}
 };
 
+// Whether writes reach disk (fsync) before returning
+enum class Durability : uint8_t {
+	NONE, // never: a machine crash can lose the latest writes, though not corrupt the database
+	SYNC, // always. LevelDB's writer queue merges concurrent writes into one synced write (group commit).
+};
+
 struct ConnectionOptions {
 	std::string db_path;
 	bool read_only = true;
 	bool create_if_missing = false;
 	size_t block_cache_size = static_cast<size_t>(8) * 1024 * 1024;
 	size_t write_buffer_size = static_cast<size_t>(4) * 1024 * 1024;
+	int bloom_filter_bits = 0; // bits per key for SST bloom filters (0 = no filters)
+	Durability durability = Durability::NONE;
+	bool async_writes = false; // write sink batches through a background writer thread
+	// Cap on the key and value bytes a transaction (or autocommit statement) may hold in memory before writing
+	size_t max_transaction_size = static_cast<size_t>(256) * 1024 * 1024;
+};
+
+class LevelDBConnection;
+
+/**
+ * Writes buffered by a transaction, in key order: the latest value of each written key, or nullopt for a deleted
+ * one. Reads through an iterator or get() given the write set see the database as if it had been applied.
+ */
+class LevelDBWriteSet {
+public:
+	using Entries = std::map<std::string, std::optional<std::string>, std::less<>>;
+
+	void put(std::string_view key, std::string_view value);
+	void del(std::string_view key);
+	// Take over other's writes, which win over ours for keys written by both
+	void merge(LevelDBWriteSet &&other);
+	// Write every buffered operation as one batch, then clear the set
+	void commit(LevelDBConnection &connection);
+	void clear() {
+		entries_.clear();
+		bytes_ = 0;
+	}
+
+	bool empty() const {
+		return entries_.empty();
+	}
+	size_t size() const {
+		return entries_.size();
+	}
+	// Key and value bytes held
+	size_t bytes() const {
+		return bytes_;
+	}
+	const Entries &entries() const {
+		return entries_;
+	}
+
+private:
+	Entries entries_;
+	size_t bytes_ = 0;
+};
+
+// A fixed view of the database: reads given it see the state at the time it was taken. Must not outlive its
+// connection.
+class LevelDBSnapshot {
+public:
+	explicit LevelDBSnapshot(leveldb::DB *db);
+	~LevelDBSnapshot();
+
+	LevelDBSnapshot(const LevelDBSnapshot &) = delete;
+	LevelDBSnapshot &operator=(const LevelDBSnapshot &) = delete;
+
+	const leveldb::Snapshot *get() const {
+		return snapshot_;
+	}
+
+private:
+	leveldb::DB *db_;
+	const leveldb::Snapshot *snapshot_;
 };
 
 class LevelDBIterator {
 public:
-	explicit LevelDBIterator(leveldb::DB *db);
+	// overlay, when given, is merged over the database and must not change while the iterator is in use. Without a
+	// snapshot the iterator reads the database as of its creation.
+	explicit LevelDBIterator(leveldb::DB *db, const LevelDBWriteSet *overlay = nullptr,
+	                         const LevelDBSnapshot *snapshot = nullptr);
 	~LevelDBIterator();
 
 	LevelDBIterator(LevelDBIterator &&other) noexcept;
@@ -40,7 +124,9 @@ public:
 
 	void seek(std::string_view key);
 	void seek_to_first();
+	void seek_to_last();
 	void next();
+	void prev();
 	bool valid() const;
 	std::string key() const;
 	std::string value() const;
@@ -49,9 +135,23 @@ public:
 
 private:
 	std::unique_ptr<leveldb::Iterator> iter_;
+	// Overlay merging (unused without an overlay): pos_ is the next overlay entry, and from_overlay_ tells which
+	// side the iterator is on. Both sides stay positioned at or past the current key.
+	const LevelDBWriteSet *overlay_ = nullptr;
+	LevelDBWriteSet::Entries::const_iterator pos_;
+	bool from_overlay_ = false;
+	bool valid_ = false;
+
+	void settle();
+	void seek_before(const std::string *limit);
 };
 
-class LevelDBConnection;
+// A batch queued on the background writer. Its fields are guarded by the connection's writer lock; see
+// LevelDBConnection::wait_for_write.
+struct LevelDBPendingWrite {
+	bool done = false;
+	std::string error; // set if the write failed
+};
 
 class LevelDBWriteBatch {
 public:
@@ -65,10 +165,19 @@ public:
 
 	void put(std::string_view key, std::string_view value);
 	void del(std::string_view key);
+	// Move other's pending operations after ours
+	void append(LevelDBWriteBatch &&other);
+	// Write the pending operations; the batch is then empty and can take more. With async writes the batch goes
+	// through the writer queue, and this waits for it. Throws if the write fails.
 	void commit();
+	// Queue the pending operations on the background writer and return without waiting; the batch is then empty.
+	// Without async writes (or pending operations) they are written right away and nullptr is returned.
+	std::shared_ptr<LevelDBPendingWrite> commit_async();
 	void discard();
 	size_t pending_count() const;
 	bool has_pending() const;
+	// Approximate in-memory size of the pending operations
+	size_t bytes() const;
 
 private:
 	LevelDBConnection *connection_;
@@ -85,11 +194,24 @@ public:
 	LevelDBConnection(const LevelDBConnection &) = delete;
 	LevelDBConnection &operator=(const LevelDBConnection &) = delete;
 
-	std::optional<std::string> get(std::string_view key);
+	// Read key as if overlay (if given) had been applied, from snapshot if given
+	std::optional<std::string> get(std::string_view key, const LevelDBWriteSet *overlay = nullptr,
+	                               const LevelDBSnapshot *snapshot = nullptr);
 	void put(std::string_view key, std::string_view value);
 	void del(std::string_view key);
-	LevelDBIterator iterator();
+	LevelDBIterator iterator(const LevelDBWriteSet *overlay = nullptr, const LevelDBSnapshot *snapshot = nullptr);
 	LevelDBWriteBatch create_batch();
+	// Pin the current state, so several readers (e.g. the threads of one scan) see the same one
+	std::unique_ptr<LevelDBSnapshot> snapshot();
+
+	// Wait until every queued background write is done. Failures are reported to the writes' owners only.
+	void wait_for_writes();
+	// Wait until a queued batch is written. Throws if its write failed.
+	void wait_for_write(LevelDBPendingWrite &pending);
+
+	//! Approximate on-disk bytes for keys in [start, limit). An empty limit means end of keyspace.
+	//! Only flushed (SST) data is counted; recent writes still in the memtable are not.
+	uint64_t approximate_size(std::string_view start, std::string_view limit);
 
 	const std::string &path() const {
 		return path_;
@@ -97,16 +219,49 @@ public:
 	bool is_read_only() const {
 		return read_only_;
 	}
+	size_t max_transaction_size() const {
+		return max_transaction_size_;
+	}
+	bool async_writes() const {
+		return async_writes_;
+	}
 	leveldb::DB *raw() {
 		return db_;
 	}
 
 private:
+	friend class LevelDBWriteBatch;
+
 	leveldb::DB *db_ = nullptr;
+	leveldb::Cache *block_cache_ = nullptr;
+	const leveldb::FilterPolicy *filter_policy_ = nullptr;
 	std::string path_;
 	bool read_only_;
+	Durability durability_;
+	size_t max_transaction_size_;
+
+	// Async writes: batches wait in a bounded queue and are written in order by writer_thread_, so a sink can hand
+	// off a full batch and go on encoding the next one. Whoever queued a batch waits for it before reporting success,
+	// and only they see its error. Reads and direct writes first wait for the queue to drain.
+	struct QueuedWrite {
+		std::unique_ptr<leveldb::WriteBatch> batch;
+		std::shared_ptr<LevelDBPendingWrite> pending;
+	};
+	bool async_writes_;
+	std::thread writer_thread_;
+	std::mutex writer_lock_;
+	std::condition_variable writer_cv_;  // wakes the writer thread
+	std::condition_variable drained_cv_; // wakes threads waiting for room in the queue, or for writes to finish
+	std::deque<QueuedWrite> write_queue_;
+	size_t queued_bytes_ = 0;
+	std::atomic<size_t> unfinished_writes_ {0}; // queued, or being written
+	bool stopping_ = false;
 
 	void check_write_allowed();
+	std::shared_ptr<LevelDBPendingWrite> enqueue_write(std::unique_ptr<leveldb::WriteBatch> batch);
+	void run_writer();
+	// Every write goes through here, which applies the durability mode
+	leveldb::Status write(leveldb::WriteBatch &batch);
 };
 
 } // namespace level_pivot
@@ -1,32 +1,69 @@
 #pragma once
 
 #include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
+#include "duckdb/common/mutex.hpp"
 #include "key_parser.hpp"
 #include "level_pivot_storage.hpp"
+#include "level_pivot_utils.hpp"
 #include <memory>
 #include <unordered_map>
 
 namespace duckdb {
 
-enum class LevelPivotTableMode : uint8_t { PIVOT, RAW };
+// PIVOT: one key per attr of a row. PACKED: one key per row, its value holding every attr (see packed_row.hpp).
+// RAW: plain key/value pairs.
+enum class LevelPivotTableMode : uint8_t { PIVOT, RAW, PACKED };
+
+inline const char *TableModeName(LevelPivotTableMode mode) {
+	switch (mode) {
+	case LevelPivotTableMode::RAW:
+		return "raw";
+	case LevelPivotTableMode::PACKED:
+		return "packed";
+	default:
+		return "pivot";
+	}
+}
+
+// Cheap size estimate for a key range, from LevelDB's approximate sizes and a sample of leading keys
+struct LevelPivotRangeEstimate {
+	idx_t rows = 0;     // identities (pivot mode) or keys (raw and packed mode)
+	uint64_t bytes = 0; // approximate on-disk bytes
+	bool exact = false; // the sample covered the whole range, so rows is a real count
+};
+
+// Column statistics gathered by level_pivot_analyze
+struct LevelPivotColumnStats {
+	Value min; // NULL if the column has no non-null values, or its type keeps no min/max
+	Value max;
+	idx_t null_count = 0;
+	idx_t non_null_count = 0;
+	idx_t distinct_count = 0; // HyperLogLog estimate
+};
 
 class LevelPivotCatalog;
 
 class LevelPivotTableEntry : public TableCatalogEntry {
 public:
-	// Pivot mode constructor
+	// Pivot and packed mode constructor
 	LevelPivotTableEntry(Catalog &catalog, SchemaCatalogEntry &schema, CreateTableInfo &info,
 	                     std::shared_ptr<level_pivot::LevelDBConnection> connection,
 	                     std::unique_ptr<level_pivot::KeyParser> parser, vector<string> identity_columns,
-	                     vector<string> attr_columns, vector<bool> column_json);
+	                     vector<string> attr_columns, vector<LevelPivotValueEncoding> column_encodings,
+	                     LevelPivotTableMode mode = LevelPivotTableMode::PIVOT);
 
 	// Raw mode constructor
 	LevelPivotTableEntry(Catalog &catalog, SchemaCatalogEntry &schema, CreateTableInfo &info,
-	                     std::shared_ptr<level_pivot::LevelDBConnection> connection, vector<bool> column_json);
+	                     std::shared_ptr<level_pivot::LevelDBConnection> connection,
+	                     vector<LevelPivotValueEncoding> column_encodings);
 
 	LevelPivotTableMode GetTableMode() const {
 		return mode_;
 	}
+	// Pivot and packed tables map keys through a key pattern and have identity columns
+	bool HasKeyPattern() const {
+		return mode_ != LevelPivotTableMode::RAW;
+	}
 
 	level_pivot::KeyParser &GetKeyParser() {
 		return *parser_;
@@ -42,17 +79,54 @@ public:
 	const vector<string> &GetIdentityColumns() const {
 		return identity_columns_;
 	}
+	// Capture encoding of each identity column, in GetIdentityColumns() order
+	const vector<level_pivot::CaptureEncoding> &GetIdentityEncodings() const {
+		return identity_encodings_;
+	}
 	const vector<string> &GetAttrColumns() const {
 		return attr_columns_;
 	}
+	// Bytes standing for an attr column in keys: its name, or its code when the table interns attr names
+	const string &GetAttrKey(idx_t attr_idx) const {
+		return attr_keys_[attr_idx];
+	}
+	const string &GetAttrKey(const string &attr_name) const;
+	// Set up dispatch from attr keys (which must outlive it) to their position in the list
+	void InitializeAttrDispatch(AttrDispatch &dispatch, const vector<std::string_view> &attr_keys) const;
+
+	// Replace attr names in keys by short codes, keeping the codes already assigned under this key pattern
+	void InternAttrNames();
+	bool HasAttrCodes() const {
+		return attr_codec_ != nullptr;
+	}
+	// Metadata key holding the attr codes assigned under a key pattern
+	static string GetAttrCodesKey(const string &pattern);
 
-	bool IsJsonColumn(idx_t col_idx) const {
-		return col_idx < column_json_.size() && column_json_[col_idx];
+	LevelPivotValueEncoding GetValueEncoding(idx_t col_idx) const {
+		return col_idx < column_encodings_.size() ? column_encodings_[col_idx] : LevelPivotValueEncoding::TEXT;
 	}
 
 	// Map column name to its index in the column list
 	idx_t GetColumnIndex(const string &name) const;
 
+	// Prefix shared by all of this table's keys ("" for raw tables, which see the whole keyspace)
+	string GetKeyPrefix() const;
+
+	// Estimate rows and bytes for keys in [start, end) (empty end = unbounded)
+	LevelPivotRangeEstimate EstimateRange(const string &start, const string &end);
+
+	// Changes whenever the statistics are set or invalidated
+	idx_t GetStatisticsVersion();
+	// Persist analyzed statistics (one entry per column) in the metadata key range and use them for planning.
+	// version is read before collecting them; returns false, keeping nothing, if the statistics changed since.
+	bool SetAnalyzedStatistics(vector<LevelPivotColumnStats> stats, idx_t version);
+	// Forget analyzed statistics and delete the stored copy. Cheap when there are none. A commit deletes the stored
+	// copy in its own batch instead and passes the version read before it, so the delete isn't repeated unless
+	// statistics were stored in the meantime.
+	void InvalidateStatistics(idx_t deleted_at_version = DConstants::INVALID_INDEX);
+	// Metadata key holding a table's analyzed statistics
+	static string GetStatisticsKey(const string &table_name);
+
 	// --- TableCatalogEntry interface ---
 	TableFunction GetScanFunction(ClientContext &context, unique_ptr<FunctionData> &bind_data) override;
 	unique_ptr<BaseStatistics> GetStatistics(ClientContext &context, column_t column_id) override;
@@ -65,11 +139,23 @@ private:
 	std::shared_ptr<level_pivot::LevelDBConnection> connection_;
 	std::unique_ptr<level_pivot::KeyParser> parser_; // nullptr for raw mode
 	vector<string> identity_columns_;
+	vector<level_pivot::CaptureEncoding> identity_encodings_;
 	vector<string> attr_columns_;
-	vector<bool> column_json_;
+	vector<string> attr_keys_; // in attr_columns_ order
+	std::unique_ptr<level_pivot::AttrCodec> attr_codec_; // nullptr unless attr names are interned
+	vector<LevelPivotValueEncoding> column_encodings_;
 	std::unordered_map<std::string, idx_t> col_name_to_index_;
 
+	// Analyzed statistics, loaded lazily from the metadata key range
+	mutex stats_lock_;
+	bool stats_loaded_ = false;
+	vector<LevelPivotColumnStats> stats_; // empty = not analyzed
+	idx_t stats_version_ = 0;
+
 	void BuildColumnIndexCache();
+	void LoadStatistics();
+	string SerializeStatistics(const vector<LevelPivotColumnStats> &stats) const;
+	bool DeserializeStatistics(std::string_view json, vector<LevelPivotColumnStats> &stats) const;
 };
 
 } // namespace duckdb
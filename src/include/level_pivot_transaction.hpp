@@ -2,32 +2,84 @@
 
 #include "duckdb/transaction/transaction_manager.hpp"
 #include "duckdb/transaction/transaction.hpp"
+#include "duckdb/common/reference_map.hpp"
+#include "level_pivot_storage.hpp"
 #include <unordered_set>
 #include <string>
 #include <string_view>
 
 namespace duckdb {
 
+class LevelPivotCatalog;
 class LevelPivotSchemaEntry;
+class LevelPivotTableEntry;
+
+//! Names of the tables whose keys a set of writes touched. Each sink thread keeps its own and merges it into the
+//! transaction when it's done.
+class LevelPivotDirtyTables {
+public:
+	//! Mark the tables every write through `table` touches: a pivot or packed table itself, and all raw tables.
+	//! The other tables its keys may belong to are returned in `candidates`, to be checked key by key.
+	void MarkWriter(LevelPivotTableEntry &table, LevelPivotSchemaEntry &schema,
+	                vector<reference<LevelPivotTableEntry>> &candidates);
+	//! Mark the candidates whose pattern matches key, removing them from the candidates
+	void CheckKey(std::string_view key, vector<reference<LevelPivotTableEntry>> &candidates);
+	void Merge(const LevelPivotDirtyTables &other);
+	//! Apply writes that touched these tables, along with dropping the tables' (now stale) statistics
+	void Commit(LevelPivotCatalog &catalog, level_pivot::LevelDBWriteSet &writes) const;
+	void Commit(LevelPivotCatalog &catalog, level_pivot::LevelDBWriteBatch &batch) const;
+
+	bool Empty() const {
+		return tables_.empty();
+	}
+	const std::unordered_set<std::string> &Tables() const {
+		return tables_;
+	}
+
+private:
+	std::unordered_set<std::string> tables_;
+};
 
 class LevelPivotTransaction : public Transaction {
 public:
 	LevelPivotTransaction(TransactionManager &manager, ClientContext &context);
 	~LevelPivotTransaction() override;
 
-	//! Check a key against all tables in the schema and mark matching ones dirty
-	void CheckKeyAgainstTables(std::string_view key, LevelPivotSchemaEntry &schema);
+	static LevelPivotTransaction &Get(ClientContext &context, Catalog &catalog);
+
+	//! Mark the tables a sink thread found dirty
+	void MergeDirtyTables(const LevelPivotDirtyTables &dirty);
+
+	//! Add a statement's writes, which are newer than the ones buffered so far. Called once the statement's sinks
+	//! are done, when no scan is reading the write set.
+	void MergeWrites(level_pivot::LevelDBWriteSet &&writes) {
+		writes_.merge(std::move(writes));
+	}
+	//! Key and value bytes buffered so far
+	size_t GetBufferedBytes() const {
+		return writes_.bytes();
+	}
+	//! Overlay for reads that should see this transaction's writes (nullptr when nothing is buffered)
+	const level_pivot::LevelDBWriteSet *GetReadOverlay() const {
+		return writes_.empty() ? nullptr : &writes_;
+	}
+	//! Apply the buffered writes to LevelDB, at COMMIT
+	void Commit(LevelPivotCatalog &catalog) {
+		dirty_tables_.Commit(catalog, writes_);
+	}
 
 	bool HasDirtyTables() const {
-		return !dirty_tables_.empty();
+		return !dirty_tables_.Empty();
 	}
 	const std::unordered_set<std::string> &GetDirtyTables() const {
-		return dirty_tables_;
+		return dirty_tables_.Tables();
 	}
 
 private:
-	std::unordered_set<std::string> dirty_tables_;
-	bool all_dirty_ = false;
+	mutex dirty_lock_;
+	LevelPivotDirtyTables dirty_tables_;
+	//! Buffered writes, applied to LevelDB as one batch at commit and dropped on rollback
+	level_pivot::LevelDBWriteSet writes_;
 };
 
 class LevelPivotTransactionManager : public TransactionManager {
@@ -40,12 +92,10 @@ public:
 	void RollbackTransaction(Transaction &transaction) override;
 	void Checkpoint(ClientContext &context, bool force = false) override;
 
-	//! Get the current transaction, or nullptr if none active
-	LevelPivotTransaction *GetCurrentTransaction();
-
 private:
 	mutex transaction_lock;
-	unique_ptr<LevelPivotTransaction> current_transaction;
+	//! Open transactions, one per connection using the database
+	reference_map_t<Transaction, unique_ptr<LevelPivotTransaction>> transactions;
 };
 
 } // namespace duckdb
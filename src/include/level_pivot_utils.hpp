@@ -1,14 +1,89 @@
 #pragma once
 
+#include "duckdb/common/limits.hpp"
 #include "duckdb/common/types/data_chunk.hpp"
+#include "duckdb/common/types/hash.hpp"
 #include "duckdb/common/types/value.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/storage/arena_allocator.hpp"
 #include "yyjson.hpp"
+#include "attr_codec.hpp"
+#include "capture_codec.hpp"
+#include "packed_row.hpp"
+#include <cstring>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace duckdb {
 
+// How the values of an attr (or raw value) column are stored, declared with a prefix in column_types:
+// TEXT (no prefix) is the value's text, JSON ('JSON INTEGER') a JSON document, BIN ('BIN DOUBLE') the value's
+// little-endian in-memory bytes (raw bytes for BLOB) and VARINT ('VARINT BIGINT') a LEB128 integer, zigzag-encoded
+// for signed types.
+enum class LevelPivotValueEncoding : uint8_t { TEXT, JSON, BIN, VARINT };
+
+inline const char *ValueEncodingName(LevelPivotValueEncoding encoding) {
+	switch (encoding) {
+	case LevelPivotValueEncoding::JSON:
+		return "JSON";
+	case LevelPivotValueEncoding::BIN:
+		return "BIN";
+	case LevelPivotValueEncoding::VARINT:
+		return "VARINT";
+	default:
+		return "TEXT";
+	}
+}
+
+// Whether values of type can be stored with encoding. BIN and VARINT work on the physical value, so they cover
+// the integer-backed types (DATE, TIMESTAMP, DECIMAL, ...) as well as the plain numbers.
+inline bool SupportsValueEncoding(LevelPivotValueEncoding encoding, const LogicalType &type) {
+	switch (encoding) {
+	case LevelPivotValueEncoding::BIN:
+		switch (type.InternalType()) {
+		case PhysicalType::BOOL:
+		case PhysicalType::INT8:
+		case PhysicalType::INT16:
+		case PhysicalType::INT32:
+		case PhysicalType::INT64:
+		case PhysicalType::INT128:
+		case PhysicalType::UINT8:
+		case PhysicalType::UINT16:
+		case PhysicalType::UINT32:
+		case PhysicalType::UINT64:
+		case PhysicalType::UINT128:
+		case PhysicalType::FLOAT:
+		case PhysicalType::DOUBLE:
+			return true;
+		default:
+			return type.id() == LogicalTypeId::BLOB;
+		}
+	case LevelPivotValueEncoding::VARINT:
+		switch (type.InternalType()) {
+		case PhysicalType::INT8:
+		case PhysicalType::INT16:
+		case PhysicalType::INT32:
+		case PhysicalType::INT64:
+		case PhysicalType::UINT8:
+		case PhysicalType::UINT16:
+		case PhysicalType::UINT32:
+		case PhysicalType::UINT64:
+			return true;
+		default:
+			return false;
+		}
+	default:
+		return true;
+	}
+}
+
+// Output columns written as text and converted by one cast per chunk (see StagedOutput)
+inline bool NeedsStaging(const LogicalType &type, LevelPivotValueEncoding encoding) {
+	return type.id() != LogicalTypeId::VARCHAR && encoding == LevelPivotValueEncoding::TEXT;
+}
+
 inline Value StringToTypedValue(std::string_view str_value, const LogicalType &type) {
 	if (type.id() == LogicalTypeId::VARCHAR) {
 		return Value(std::string(str_value));
@@ -62,26 +137,682 @@ inline Value JsonStringToTypedValue(std::string_view str_value, const LogicalTyp
 	return result;
 }
 
+// Quote and escape str as a JSON string into out
+inline void JsonQuoteString(std::string_view str, std::string &out) {
+	auto *doc = duckdb_yyjson::yyjson_mut_doc_new(nullptr);
+	auto *root = duckdb_yyjson::yyjson_mut_strncpy(doc, str.data(), str.size());
+	duckdb_yyjson::yyjson_mut_doc_set_root(doc, root);
+
+	size_t json_len = 0;
+	char *json_str = duckdb_yyjson::yyjson_mut_write(doc, 0, &json_len);
+	out.assign(json_str, json_len);
+	free(json_str);
+	duckdb_yyjson::yyjson_mut_doc_free(doc);
+}
+
 // Serialize a DuckDB Value into a JSON-encoded string for LevelDB storage.
 // VARCHAR values get JSON string quoting/escaping. Numeric/boolean types use ToString() (already valid JSON).
 inline std::string TypedValueToJsonString(const Value &val, const LogicalType &type) {
 	if (type.id() == LogicalTypeId::VARCHAR) {
-		auto str = val.ToString();
-		auto *doc = duckdb_yyjson::yyjson_mut_doc_new(nullptr);
-		auto *root = duckdb_yyjson::yyjson_mut_strncpy(doc, str.data(), str.size());
-		duckdb_yyjson::yyjson_mut_doc_set_root(doc, root);
-
-		size_t json_len = 0;
-		char *json_str = duckdb_yyjson::yyjson_mut_write(doc, 0, &json_len);
-		std::string result(json_str, json_len);
-		free(json_str);
-		duckdb_yyjson::yyjson_mut_doc_free(doc);
+		std::string result;
+		JsonQuoteString(val.ToString(), result);
 		return result;
 	}
 
 	return val.ToString();
 }
 
+// Write a string_view directly into a DuckDB output vector (bypasses Value allocation for VARCHAR)
+inline void WriteStringDirect(Vector &vec, idx_t row, std::string_view sv) {
+	FlatVector::GetData<string_t>(vec)[row] = StringVector::AddString(vec, sv.data(), sv.size());
+}
+
+inline void WriteValueDirect(Vector &vec, idx_t row, std::string_view sv, const LogicalType &type,
+                             bool is_json = false) {
+	if (is_json) {
+		auto val = JsonStringToTypedValue(sv, type);
+		if (val.IsNull()) {
+			FlatVector::SetNull(vec, row, true);
+		} else if (type.id() == LogicalTypeId::VARCHAR) {
+			auto str = val.ToString();
+			WriteStringDirect(vec, row, str);
+		} else {
+			vec.SetValue(row, val);
+		}
+		return;
+	}
+	if (type.id() == LogicalTypeId::VARCHAR) {
+		WriteStringDirect(vec, row, sv);
+	} else {
+		vec.SetValue(row, StringToTypedValue(sv, type));
+	}
+}
+
+template <class T>
+void AppendBinaryValue(std::string &out, LevelPivotValueEncoding encoding, T value) {
+	if (encoding == LevelPivotValueEncoding::BIN) {
+		// DuckDB only runs on little-endian hosts, so the in-memory bytes are the stored bytes
+		out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+	} else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+		auto wide = static_cast<int64_t>(value);
+		level_pivot::append_varint(out, (static_cast<uint64_t>(wide) << 1) ^ static_cast<uint64_t>(wide >> 63));
+	} else if constexpr (std::is_integral<T>::value) {
+		level_pivot::append_varint(out, static_cast<uint64_t>(value));
+	} else {
+		throw InternalException("VARINT encoding needs an integer type");
+	}
+}
+
+// Stored form of a non-NULL value of a BIN or VARINT column; the value has the column's type
+inline std::string EncodeBinaryValue(const Value &val, LevelPivotValueEncoding encoding) {
+	std::string result;
+	switch (val.type().InternalType()) {
+	case PhysicalType::BOOL:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<bool>());
+		break;
+	case PhysicalType::INT8:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<int8_t>());
+		break;
+	case PhysicalType::INT16:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<int16_t>());
+		break;
+	case PhysicalType::INT32:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<int32_t>());
+		break;
+	case PhysicalType::INT64:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<int64_t>());
+		break;
+	case PhysicalType::INT128:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<hugeint_t>());
+		break;
+	case PhysicalType::UINT8:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<uint8_t>());
+		break;
+	case PhysicalType::UINT16:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<uint16_t>());
+		break;
+	case PhysicalType::UINT32:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<uint32_t>());
+		break;
+	case PhysicalType::UINT64:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<uint64_t>());
+		break;
+	case PhysicalType::UINT128:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<uhugeint_t>());
+		break;
+	case PhysicalType::FLOAT:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<float>());
+		break;
+	case PhysicalType::DOUBLE:
+		AppendBinaryValue(result, encoding, val.GetValueUnsafe<double>());
+		break;
+	case PhysicalType::VARCHAR:
+		// BIN BLOB: the bytes themselves
+		result = StringValue::Get(val);
+		break;
+	default:
+		throw InternalException("Type %s has no binary value encoding", val.type().ToString());
+	}
+	return result;
+}
+
+template <class T>
+bool TryReadBinaryValue(std::string_view sv, LevelPivotValueEncoding encoding, T &value) {
+	if (encoding == LevelPivotValueEncoding::BIN) {
+		if (sv.size() != sizeof(T)) {
+			return false;
+		}
+		if constexpr (std::is_same<T, bool>::value) {
+			// Any other byte isn't a valid bool
+			auto byte = static_cast<uint8_t>(sv[0]);
+			if (byte > 1) {
+				return false;
+			}
+			value = byte != 0;
+		} else {
+			memcpy(&value, sv.data(), sizeof(T));
+		}
+		return true;
+	}
+	if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value) {
+		uint64_t raw;
+		size_t pos = 0;
+		if (!level_pivot::read_varint(sv, pos, raw) || pos != sv.size()) {
+			return false;
+		}
+		if constexpr (std::is_signed<T>::value) {
+			auto wide = static_cast<int64_t>((raw >> 1) ^ (~(raw & 1) + 1));
+			if (wide < static_cast<int64_t>(NumericLimits<T>::Minimum()) ||
+			    wide > static_cast<int64_t>(NumericLimits<T>::Maximum())) {
+				return false;
+			}
+			value = static_cast<T>(wide);
+		} else {
+			if (raw > static_cast<uint64_t>(NumericLimits<T>::Maximum())) {
+				return false;
+			}
+			value = static_cast<T>(raw);
+		}
+		return true;
+	}
+	return false;
+}
+
+template <class T>
+bool TryWriteBinarySlot(Vector &vec, idx_t row, std::string_view sv, LevelPivotValueEncoding encoding) {
+	return TryReadBinaryValue(sv, encoding, FlatVector::GetData<T>(vec)[row]);
+}
+
+// Decode a BIN or VARINT value straight into its vector slot. Returns false if the bytes don't have the encoding's
+// shape (wrong length, bad varint, out of range).
+inline bool TryWriteBinaryValue(Vector &vec, idx_t row, std::string_view sv, LevelPivotValueEncoding encoding) {
+	switch (vec.GetType().InternalType()) {
+	case PhysicalType::BOOL:
+		return TryWriteBinarySlot<bool>(vec, row, sv, encoding);
+	case PhysicalType::INT8:
+		return TryWriteBinarySlot<int8_t>(vec, row, sv, encoding);
+	case PhysicalType::INT16:
+		return TryWriteBinarySlot<int16_t>(vec, row, sv, encoding);
+	case PhysicalType::INT32:
+		return TryWriteBinarySlot<int32_t>(vec, row, sv, encoding);
+	case PhysicalType::INT64:
+		return TryWriteBinarySlot<int64_t>(vec, row, sv, encoding);
+	case PhysicalType::INT128:
+		return TryWriteBinarySlot<hugeint_t>(vec, row, sv, encoding);
+	case PhysicalType::UINT8:
+		return TryWriteBinarySlot<uint8_t>(vec, row, sv, encoding);
+	case PhysicalType::UINT16:
+		return TryWriteBinarySlot<uint16_t>(vec, row, sv, encoding);
+	case PhysicalType::UINT32:
+		return TryWriteBinarySlot<uint32_t>(vec, row, sv, encoding);
+	case PhysicalType::UINT64:
+		return TryWriteBinarySlot<uint64_t>(vec, row, sv, encoding);
+	case PhysicalType::UINT128:
+		return TryWriteBinarySlot<uhugeint_t>(vec, row, sv, encoding);
+	case PhysicalType::FLOAT:
+		return TryWriteBinarySlot<float>(vec, row, sv, encoding);
+	case PhysicalType::DOUBLE:
+		return TryWriteBinarySlot<double>(vec, row, sv, encoding);
+	case PhysicalType::VARCHAR:
+		WriteStringDirect(vec, row, sv);
+		return true;
+	default:
+		return false;
+	}
+}
+
+// The encoding is authoritative: bytes that don't decode are an error, never reinterpreted as text, which could
+// silently misread them (the 4 bytes "1234" are also a valid BIN INTEGER).
+inline void WriteBinaryValue(Vector &vec, idx_t row, std::string_view sv, LevelPivotValueEncoding encoding) {
+	if (!TryWriteBinaryValue(vec, row, sv, encoding)) {
+		throw InvalidInputException("Stored value of %llu bytes is not a valid %s %s", sv.size(),
+		                            ValueEncodingName(encoding), vec.GetType().ToString());
+	}
+}
+
+// Stored form of a non-NULL value of an attr (or raw value) column
+inline std::string EncodeStoredValue(const Value &val, const LogicalType &type, LevelPivotValueEncoding encoding) {
+	switch (encoding) {
+	case LevelPivotValueEncoding::JSON:
+		return TypedValueToJsonString(val, type);
+	case LevelPivotValueEncoding::BIN:
+	case LevelPivotValueEncoding::VARINT:
+		return EncodeBinaryValue(val, encoding);
+	default:
+		return val.ToString();
+	}
+}
+
+// Typed value of a stored attr (or raw value) string
+inline Value StoredToTypedValue(std::string_view sv, const LogicalType &type, LevelPivotValueEncoding encoding) {
+	switch (encoding) {
+	case LevelPivotValueEncoding::JSON:
+		return JsonStringToTypedValue(sv, type);
+	case LevelPivotValueEncoding::BIN:
+	case LevelPivotValueEncoding::VARINT: {
+		Vector vec(type, 1);
+		WriteBinaryValue(vec, 0, sv, encoding);
+		return vec.GetValue(0);
+	}
+	default:
+		return StringToTypedValue(sv, type);
+	}
+}
+
+// Key form of an identity value: its text for plain captures, fixed-width order-preserving bytes for typed ones
+// ({ts:i64be}, {day:date}, ...). Returns false if the value doesn't fit the capture's encoding.
+inline bool TryEncodeCapture(level_pivot::CaptureEncoding encoding, const Value &value, std::string &out) {
+	return level_pivot::encode_capture(encoding, value.ToString(), out);
+}
+
+inline std::string EncodeCapture(level_pivot::CaptureEncoding encoding, const Value &value, const string &name) {
+	std::string result;
+	if (!TryEncodeCapture(encoding, value, result)) {
+		throw InvalidInputException("Value '%s' does not fit the %s encoding of identity column '%s'",
+		                            value.ToString(), level_pivot::capture_encoding_name(encoding), name);
+	}
+	return result;
+}
+
+// The column type a typed capture decodes to without a cast
+inline bool IsNativeCaptureType(level_pivot::CaptureEncoding encoding, const LogicalType &type) {
+	using level_pivot::CaptureEncoding;
+	switch (encoding) {
+	case CaptureEncoding::I32BE:
+		return type.id() == LogicalTypeId::INTEGER;
+	case CaptureEncoding::I64BE:
+		return type.id() == LogicalTypeId::BIGINT;
+	case CaptureEncoding::U32BE:
+		return type.id() == LogicalTypeId::UINTEGER;
+	case CaptureEncoding::U64BE:
+		return type.id() == LogicalTypeId::UBIGINT;
+	default:
+		return false;
+	}
+}
+
+// Decode an integer capture straight into its native column type (see IsNativeCaptureType)
+inline void WriteCaptureDirect(Vector &vec, idx_t row, std::string_view bytes, level_pivot::CaptureEncoding encoding) {
+	switch (vec.GetType().id()) {
+	case LogicalTypeId::INTEGER:
+		FlatVector::GetData<int32_t>(vec)[row] = static_cast<int32_t>(level_pivot::decode_signed_capture(bytes));
+		break;
+	case LogicalTypeId::BIGINT:
+		FlatVector::GetData<int64_t>(vec)[row] = level_pivot::decode_signed_capture(bytes);
+		break;
+	case LogicalTypeId::UINTEGER:
+		FlatVector::GetData<uint32_t>(vec)[row] = static_cast<uint32_t>(level_pivot::decode_unsigned_capture(bytes));
+		break;
+	case LogicalTypeId::UBIGINT:
+		FlatVector::GetData<uint64_t>(vec)[row] = level_pivot::decode_unsigned_capture(bytes);
+		break;
+	default:
+		throw InternalException("Capture encoding %s has no native column type",
+		                        level_pivot::capture_encoding_name(encoding));
+	}
+}
+
+// Typed value of a capture's key bytes
+inline Value CaptureToTypedValue(level_pivot::CaptureEncoding encoding, std::string_view bytes,
+                                 const LogicalType &type) {
+	if (encoding == level_pivot::CaptureEncoding::TEXT) {
+		return StringToTypedValue(bytes, type);
+	}
+	std::string text;
+	level_pivot::decode_capture(encoding, bytes, text);
+	return StringToTypedValue(text, type);
+}
+
+// yyjson allocator backed by an arena that is reset once per chunk, so decoding JSON values doesn't hit malloc
+class JsonArena {
+public:
+	JsonArena() : arena_(Allocator::DefaultAllocator()) {
+		alc_.malloc = Allocate;
+		alc_.realloc = Reallocate;
+		alc_.free = Free;
+		alc_.ctx = this;
+	}
+	JsonArena(const JsonArena &) = delete;
+	JsonArena &operator=(const JsonArena &) = delete;
+
+	duckdb_yyjson::yyjson_alc *Get() {
+		return &alc_;
+	}
+	void Reset() {
+		arena_.Reset();
+	}
+
+private:
+	ArenaAllocator arena_;
+	duckdb_yyjson::yyjson_alc alc_;
+
+	static void *Allocate(void *ctx, size_t size) {
+		return static_cast<JsonArena *>(ctx)->arena_.Allocate(size);
+	}
+	static void *Reallocate(void *ctx, void *ptr, size_t old_size, size_t size) {
+		return static_cast<JsonArena *>(ctx)->arena_.Reallocate(static_cast<data_ptr_t>(ptr), old_size, size);
+	}
+	static void Free(void *ctx, void *ptr) {
+		// Freed all at once by Reset()
+	}
+};
+
+// Store a parsed JSON number or boolean straight into a typed slot. Returns false for combinations that need
+// DuckDB's casts (out-of-range integers, decimals, temporal types, ...).
+inline bool TryWriteJsonScalar(Vector &vec, idx_t row, duckdb_yyjson::yyjson_val *val) {
+	using namespace duckdb_yyjson;
+	switch (vec.GetType().id()) {
+	case LogicalTypeId::BOOLEAN:
+		if (yyjson_is_bool(val)) {
+			FlatVector::GetData<bool>(vec)[row] = yyjson_get_bool(val);
+			return true;
+		}
+		return false;
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT: {
+		int64_t result;
+		auto max_int64 = static_cast<uint64_t>(NumericLimits<int64_t>::Maximum());
+		if (yyjson_is_sint(val)) {
+			result = yyjson_get_sint(val);
+		} else if (yyjson_is_uint(val) && yyjson_get_uint(val) <= max_int64) {
+			result = static_cast<int64_t>(yyjson_get_uint(val));
+		} else {
+			return false;
+		}
+		if (vec.GetType().id() == LogicalTypeId::BIGINT) {
+			FlatVector::GetData<int64_t>(vec)[row] = result;
+			return true;
+		}
+		if (result < NumericLimits<int32_t>::Minimum() || result > NumericLimits<int32_t>::Maximum()) {
+			return false;
+		}
+		FlatVector::GetData<int32_t>(vec)[row] = static_cast<int32_t>(result);
+		return true;
+	}
+	case LogicalTypeId::DOUBLE:
+	case LogicalTypeId::FLOAT: {
+		double result;
+		if (yyjson_is_real(val)) {
+			result = yyjson_get_real(val);
+		} else if (yyjson_is_sint(val)) {
+			result = static_cast<double>(yyjson_get_sint(val));
+		} else if (yyjson_is_uint(val)) {
+			result = static_cast<double>(yyjson_get_uint(val));
+		} else {
+			return false;
+		}
+		if (vec.GetType().id() == LogicalTypeId::DOUBLE) {
+			FlatVector::GetData<double>(vec)[row] = result;
+		} else {
+			FlatVector::GetData<float>(vec)[row] = static_cast<float>(result);
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+// Decode a JSON-encoded value straight into a vector slot, allocating the document from alc.
+// Same results as JsonStringToTypedValue, except that JSON reals keep full precision.
+inline void WriteJsonDirect(Vector &vec, idx_t row, std::string_view sv, duckdb_yyjson::yyjson_alc *alc) {
+	using namespace duckdb_yyjson;
+	auto &type = vec.GetType();
+	// Without YYJSON_READ_INSITU the input is only read, never modified
+	auto *doc = yyjson_read_opts(const_cast<char *>(sv.data()), sv.size(), 0, alc, nullptr);
+	if (!doc) {
+		WriteValueDirect(vec, row, sv, type);
+		return;
+	}
+
+	auto *root = yyjson_doc_get_root(doc);
+	if (yyjson_is_null(root)) {
+		FlatVector::SetNull(vec, row, true);
+	} else if (type.id() == LogicalTypeId::VARCHAR) {
+		if (yyjson_is_str(root)) {
+			WriteStringDirect(vec, row, std::string_view(yyjson_get_str(root), yyjson_get_len(root)));
+		} else {
+			size_t json_len = 0;
+			char *json_str = yyjson_val_write_opts(root, 0, alc, &json_len, nullptr);
+			WriteStringDirect(vec, row, json_str ? std::string_view(json_str, json_len) : sv);
+		}
+	} else if (!TryWriteJsonScalar(vec, row, root)) {
+		// Uncommon type combinations take the Value path
+		WriteValueDirect(vec, row, sv, type, true);
+	}
+	yyjson_doc_free(doc);
+}
+
+// Fills an output chunk from stored strings. VARCHAR columns get the bytes directly; other types are staged as
+// strings and converted with one vectorized cast per column in Finish(), instead of a Value + cast per cell.
+// JSON columns are decoded in place with arena-allocated documents, BIN and VARINT columns with memcpy/varint reads.
+class StagedOutput {
+public:
+	// stage[i]: output column i is filled from stored strings but isn't VARCHAR
+	void Initialize(const vector<bool> &stage) {
+		vector<LogicalType> staging_types;
+		staging_index_.assign(stage.size(), DConstants::INVALID_INDEX);
+		for (idx_t col = 0; col < stage.size(); col++) {
+			if (stage[col]) {
+				staging_index_[col] = staged_columns_.size();
+				staged_columns_.push_back(col);
+				staging_types.push_back(LogicalType::VARCHAR);
+			}
+		}
+		if (!staging_types.empty()) {
+			staging_.Initialize(Allocator::DefaultAllocator(), staging_types);
+		}
+	}
+
+	// Write the stored string of a cell. JSON, BIN and VARINT columns are decoded right away (and aren't staged).
+	void Write(DataChunk &output, idx_t col, idx_t row, std::string_view sv,
+	           LevelPivotValueEncoding encoding = LevelPivotValueEncoding::TEXT) {
+		switch (encoding) {
+		case LevelPivotValueEncoding::JSON:
+			WriteJsonDirect(output.data[col], row, sv, json_arena_.Get());
+			break;
+		case LevelPivotValueEncoding::BIN:
+		case LevelPivotValueEncoding::VARINT:
+			WriteBinaryValue(output.data[col], row, sv, encoding);
+			break;
+		default:
+			WriteStringDirect(Target(output, col), row, sv);
+			break;
+		}
+	}
+
+	// Write an identity column from a capture's key bytes. Integer captures in their native column type are decoded
+	// directly (that column must not be staged); other typed captures go through their text form.
+	void WriteCapture(DataChunk &output, idx_t col, idx_t row, std::string_view bytes,
+	                  level_pivot::CaptureEncoding encoding) {
+		if (encoding == level_pivot::CaptureEncoding::TEXT) {
+			Write(output, col, row, bytes);
+		} else if (staging_index_[col] == DConstants::INVALID_INDEX &&
+		           IsNativeCaptureType(encoding, output.data[col].GetType())) {
+			WriteCaptureDirect(output.data[col], row, bytes, encoding);
+		} else {
+			level_pivot::decode_capture(encoding, bytes, capture_text_);
+			Write(output, col, row, capture_text_);
+		}
+	}
+
+	void SetNull(DataChunk &output, idx_t col, idx_t row) {
+		FlatVector::SetNull(Target(output, col), row, true);
+	}
+
+	// Convert the staged columns and set the chunk's cardinality
+	void Finish(DataChunk &output, idx_t count) {
+		for (idx_t i = 0; i < staged_columns_.size(); i++) {
+			VectorOperations::DefaultCast(staging_.data[i], output.data[staged_columns_[i]], count);
+		}
+		if (!staged_columns_.empty()) {
+			staging_.Reset();
+		}
+		json_arena_.Reset();
+		output.SetCardinality(count);
+	}
+
+private:
+	DataChunk staging_;            // one VARCHAR vector per staged column
+	vector<idx_t> staging_index_;  // output column -> staging vector (INVALID_INDEX = written directly)
+	vector<idx_t> staged_columns_; // staging vector -> output column
+	JsonArena json_arena_;         // JSON documents of the current chunk
+	std::string capture_text_;     // decoded typed capture
+
+	Vector &Target(DataChunk &output, idx_t col) {
+		auto idx = staging_index_[col];
+		return idx == DConstants::INVALID_INDEX ? output.data[col] : staging_.data[idx];
+	}
+};
+
+// How StoredInput reads an input column
+enum class StoredInputForm : uint8_t {
+	SKIP,  // not read
+	TEXT,  // as the value's text (what Value::ToString gives)
+	TYPED, // as physical values: BIN and VARINT columns, and integer captures in their native type
+};
+
+// Reads the cells of input chunks in their stored or key form, the write-side counterpart of StagedOutput. Columns
+// are accessed through UnifiedVectorFormat; text of non-VARCHAR columns comes from one vectorized cast per column
+// and chunk, and BIN/VARINT values are formatted straight from their slots into a reused buffer.
+class StoredInput {
+public:
+	// One form per chunk column
+	void Initialize(const vector<LogicalType> &types, const vector<StoredInputForm> &forms) {
+		types_ = types;
+		forms_ = forms;
+		formats_.resize(types.size());
+		vector<LogicalType> cast_types;
+		cast_index_.assign(types.size(), DConstants::INVALID_INDEX);
+		for (idx_t col = 0; col < types.size(); col++) {
+			if (forms[col] == StoredInputForm::TEXT && types[col].id() != LogicalTypeId::VARCHAR) {
+				cast_index_[col] = cast_types.size();
+				cast_types.push_back(LogicalType::VARCHAR);
+			}
+		}
+		if (!cast_types.empty()) {
+			cast_.Initialize(Allocator::DefaultAllocator(), cast_types);
+		}
+	}
+
+	static StoredInputForm FormOf(LevelPivotValueEncoding encoding) {
+		return encoding == LevelPivotValueEncoding::BIN || encoding == LevelPivotValueEncoding::VARINT
+		           ? StoredInputForm::TYPED
+		           : StoredInputForm::TEXT;
+	}
+	static StoredInputForm FormOf(level_pivot::CaptureEncoding encoding, const LogicalType &type) {
+		return IsNativeCaptureType(encoding, type) ? StoredInputForm::TYPED : StoredInputForm::TEXT;
+	}
+
+	// Prepare the columns of a new chunk
+	void Load(DataChunk &chunk) {
+		if (cast_.ColumnCount() > 0) {
+			cast_.Reset();
+		}
+		for (idx_t col = 0; col < forms_.size(); col++) {
+			if (forms_[col] == StoredInputForm::SKIP) {
+				continue;
+			}
+			auto idx = cast_index_[col];
+			if (idx == DConstants::INVALID_INDEX) {
+				chunk.data[col].ToUnifiedFormat(chunk.size(), formats_[col]);
+			} else {
+				VectorOperations::DefaultCast(chunk.data[col], cast_.data[idx], chunk.size());
+				cast_.data[idx].ToUnifiedFormat(chunk.size(), formats_[col]);
+			}
+		}
+	}
+
+	bool IsNull(idx_t col, idx_t row) const {
+		auto &format = formats_[col];
+		return !format.validity.RowIsValid(format.sel->get_index(row));
+	}
+
+	// Text of a TEXT cell (the bytes of a BLOB in a TYPED one)
+	std::string_view Text(idx_t col, idx_t row) const {
+		auto &str = Slot<string_t>(col, row);
+		return std::string_view(str.GetData(), str.GetSize());
+	}
+
+	// Stored form of a non-NULL attr (or raw value) cell, read in FormOf(encoding). Valid until the next call.
+	std::string_view Stored(idx_t col, idx_t row, LevelPivotValueEncoding encoding) {
+		switch (encoding) {
+		case LevelPivotValueEncoding::JSON:
+			if (types_[col].id() != LogicalTypeId::VARCHAR) {
+				return Text(col, row); // numbers and booleans are their own JSON
+			}
+			JsonQuoteString(Text(col, row), buffer_);
+			return buffer_;
+		case LevelPivotValueEncoding::BIN:
+		case LevelPivotValueEncoding::VARINT:
+			return FormatBinary(col, row, encoding);
+		default:
+			return Text(col, row);
+		}
+	}
+
+	// Key form of a non-NULL identity cell, read in FormOf(encoding, type). Returns false if it doesn't fit.
+	bool EncodeCapture(idx_t col, idx_t row, level_pivot::CaptureEncoding encoding, std::string &out) const {
+		if (forms_[col] == StoredInputForm::TYPED) {
+			auto width = level_pivot::capture_encoding_width(encoding);
+			switch (encoding) {
+			case level_pivot::CaptureEncoding::I32BE:
+				level_pivot::encode_signed_capture(Slot<int32_t>(col, row), width, out);
+				return true;
+			case level_pivot::CaptureEncoding::I64BE:
+				level_pivot::encode_signed_capture(Slot<int64_t>(col, row), width, out);
+				return true;
+			case level_pivot::CaptureEncoding::U32BE:
+				level_pivot::encode_unsigned_capture(Slot<uint32_t>(col, row), width, out);
+				return true;
+			case level_pivot::CaptureEncoding::U64BE:
+				level_pivot::encode_unsigned_capture(Slot<uint64_t>(col, row), width, out);
+				return true;
+			default:
+				break;
+			}
+		}
+		return level_pivot::encode_capture(encoding, Text(col, row), out);
+	}
+
+private:
+	vector<LogicalType> types_;
+	vector<StoredInputForm> forms_;
+	vector<UnifiedVectorFormat> formats_;
+	DataChunk cast_;           // one VARCHAR vector per cast column
+	vector<idx_t> cast_index_; // chunk column -> cast vector (INVALID_INDEX = read in place)
+	std::string buffer_;       // formatted cell
+
+	template <class T>
+	const T &Slot(idx_t col, idx_t row) const {
+		auto &format = formats_[col];
+		return UnifiedVectorFormat::GetData<T>(format)[format.sel->get_index(row)];
+	}
+
+	template <class T>
+	std::string_view FormatSlot(idx_t col, idx_t row, LevelPivotValueEncoding encoding) {
+		buffer_.clear();
+		AppendBinaryValue(buffer_, encoding, Slot<T>(col, row));
+		return buffer_;
+	}
+
+	std::string_view FormatBinary(idx_t col, idx_t row, LevelPivotValueEncoding encoding) {
+		switch (types_[col].InternalType()) {
+		case PhysicalType::BOOL:
+			return FormatSlot<bool>(col, row, encoding);
+		case PhysicalType::INT8:
+			return FormatSlot<int8_t>(col, row, encoding);
+		case PhysicalType::INT16:
+			return FormatSlot<int16_t>(col, row, encoding);
+		case PhysicalType::INT32:
+			return FormatSlot<int32_t>(col, row, encoding);
+		case PhysicalType::INT64:
+			return FormatSlot<int64_t>(col, row, encoding);
+		case PhysicalType::INT128:
+			return FormatSlot<hugeint_t>(col, row, encoding);
+		case PhysicalType::UINT8:
+			return FormatSlot<uint8_t>(col, row, encoding);
+		case PhysicalType::UINT16:
+			return FormatSlot<uint16_t>(col, row, encoding);
+		case PhysicalType::UINT32:
+			return FormatSlot<uint32_t>(col, row, encoding);
+		case PhysicalType::UINT64:
+			return FormatSlot<uint64_t>(col, row, encoding);
+		case PhysicalType::UINT128:
+			return FormatSlot<uhugeint_t>(col, row, encoding);
+		case PhysicalType::FLOAT:
+			return FormatSlot<float>(col, row, encoding);
+		case PhysicalType::DOUBLE:
+			return FormatSlot<double>(col, row, encoding);
+		case PhysicalType::VARCHAR:
+			// BIN BLOB: the bytes themselves
+			return Text(col, row);
+		default:
+			throw InternalException("Type %s has no binary value encoding", types_[col].ToString());
+		}
+	}
+};
+
 inline bool IsWithinPrefix(std::string_view key, std::string_view prefix) {
 	if (prefix.empty()) {
 		return true;
@@ -92,6 +823,42 @@ inline bool IsWithinPrefix(std::string_view key, std::string_view prefix) {
 	return key.compare(0, prefix.size(), prefix.data(), prefix.size()) == 0;
 }
 
+// Smallest key greater than every key starting with prefix. Returns "" (unbounded) if no such key exists.
+inline std::string PrefixSuccessor(std::string_view prefix) {
+	std::string result(prefix);
+	while (!result.empty()) {
+		auto last = static_cast<unsigned char>(result.back());
+		if (last != 0xff) {
+			result.back() = static_cast<char>(last + 1);
+			return result;
+		}
+		result.pop_back();
+	}
+	return result;
+}
+
+// Keys from this prefix on to METADATA_KEY_END hold extension metadata (e.g. analyzed statistics). They are hidden
+// from table scans; user keys on either side of them are not.
+inline constexpr std::string_view METADATA_KEY_PREFIX("\xff\xff"
+                                                      "level_pivot##");
+// PrefixSuccessor(METADATA_KEY_PREFIX)
+inline constexpr std::string_view METADATA_KEY_END("\xff\xff"
+                                                   "level_pivot#$");
+
+inline bool IsMetadataKey(std::string_view key) {
+	return key >= METADATA_KEY_PREFIX && key < METADATA_KEY_END;
+}
+
+// True if [start, end) (empty end = unbounded) contains any metadata key
+inline bool OverlapsMetadataKeys(std::string_view start, std::string_view end) {
+	return start < METADATA_KEY_END && (end.empty() || end > METADATA_KEY_PREFIX);
+}
+
+// True if key lies before the exclusive upper bound end (empty end = unbounded)
+inline bool IsBeforeEnd(std::string_view key, std::string_view end) {
+	return end.empty() || key < end;
+}
+
 inline bool IdentityMatches(const std::vector<std::string> &identity, const std::string_view *captures, size_t count) {
 	if (identity.size() != count) {
 		return false;
@@ -104,12 +871,87 @@ inline bool IdentityMatches(const std::vector<std::string> &identity, const std:
 	return true;
 }
 
+// Maps attr names to their position in a fixed list with a hash probe, so matching a key's attr costs the same
+// however many attrs a table has. The table is kept at most a quarter full, so probes rarely go past one slot.
+class AttrDispatch {
+public:
+	// The names' bytes must outlive the dispatch
+	void Initialize(const vector<std::string_view> &names) {
+		codec_ = nullptr;
+		names_ = names;
+		hashes_.clear();
+		idx_t capacity = 4;
+		while (capacity < names.size() * 4) {
+			capacity *= 2;
+		}
+		mask_ = capacity - 1;
+		slots_.assign(capacity, DConstants::INVALID_INDEX);
+		for (idx_t i = 0; i < names_.size(); i++) {
+			auto hash = Hash(names_[i].data(), names_[i].size());
+			hashes_.push_back(hash);
+			auto slot = hash & mask_;
+			while (slots_[slot] != DConstants::INVALID_INDEX) {
+				slot = (slot + 1) & mask_;
+			}
+			slots_[slot] = i;
+		}
+	}
+
+	// Interned attr names: names are codes of codec (which must outlive the dispatch), looked up by their value
+	void InitializeCodes(const level_pivot::AttrCodec &codec, const vector<std::string_view> &names) {
+		codec_ = &codec;
+		by_code_.clear();
+		for (idx_t i = 0; i < names.size(); i++) {
+			uint32_t code;
+			if (!codec.decode(names[i], code)) {
+				throw InternalException("Attr key is not an attr code");
+			}
+			if (code >= by_code_.size()) {
+				by_code_.resize(code + 1, DConstants::INVALID_INDEX);
+			}
+			by_code_[code] = i;
+		}
+	}
+
+	// Position of name in the list, or DConstants::INVALID_INDEX
+	idx_t Find(std::string_view name) const {
+		if (codec_) {
+			uint32_t code;
+			if (!codec_->decode(name, code) || code >= by_code_.size()) {
+				return DConstants::INVALID_INDEX;
+			}
+			return by_code_[code];
+		}
+		auto hash = Hash(name.data(), name.size());
+		for (auto slot = hash & mask_; slots_[slot] != DConstants::INVALID_INDEX; slot = (slot + 1) & mask_) {
+			auto idx = slots_[slot];
+			if (hashes_[idx] == hash && names_[idx] == name) {
+				return idx;
+			}
+		}
+		return DConstants::INVALID_INDEX;
+	}
+
+private:
+	vector<std::string_view> names_;
+	vector<hash_t> hashes_;
+	vector<idx_t> slots_;
+	idx_t mask_ = 0;
+	const level_pivot::AttrCodec *codec_ = nullptr;
+	vector<idx_t> by_code_; // attr code -> position
+};
+
+// Key forms of the identity columns at col_offset.. (one encoding per column)
 inline void ExtractIdentityValues(std::vector<std::string> &out, DataChunk &chunk, idx_t row, idx_t col_offset,
-                                  idx_t num_cols) {
+                                  const vector<level_pivot::CaptureEncoding> &encodings) {
 	out.clear();
-	for (idx_t i = 0; i < num_cols; i++) {
+	for (idx_t i = 0; i < encodings.size(); i++) {
 		auto val = chunk.data[col_offset + i].GetValue(row);
-		out.push_back(val.IsNull() ? "" : val.ToString());
+		out.emplace_back();
+		// Row ids come from scanned rows, so their values always fit the encoding
+		if (!val.IsNull() && !TryEncodeCapture(encodings[i], val, out.back())) {
+			throw InternalException("Identity value '%s' does not fit its capture encoding", val.ToString());
+		}
 	}
 }
 
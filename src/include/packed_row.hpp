@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace level_pivot {
+
+inline void append_varint(std::string &out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+// Decode the varint at pos and advance pos past it. Returns false if it's truncated or longer than 10 bytes.
+inline bool read_varint(std::string_view data, size_t &pos, uint64_t &value) {
+	value = 0;
+	for (size_t i = 0; i < 10 && pos < data.size(); ++i) {
+		auto byte = static_cast<uint8_t>(data[pos++]);
+		value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Value of a packed-mode key, holding every attr of a row:
+ *
+ *   varint column count | null bitmap (bit i set = column i is NULL) | per non-NULL column: varint length, bytes
+ *
+ * Columns are the table's attr columns in declaration order; each one's bytes are its stored form (text, JSON,
+ * BIN, ...). A row with fewer columns than the table reads the missing ones as NULL, so columns can be appended.
+ */
+inline void pack_row(const std::string_view *fields, const bool *present, size_t count, std::string &out) {
+	out.clear();
+	append_varint(out, count);
+	auto bitmap_offset = out.size();
+	out.append((count + 7) / 8, '\0');
+	for (size_t i = 0; i < count; ++i) {
+		if (!present[i]) {
+			out[bitmap_offset + i / 8] = static_cast<char>(out[bitmap_offset + i / 8] | (1 << (i % 8)));
+			continue;
+		}
+		append_varint(out, fields[i].size());
+		out.append(fields[i].data(), fields[i].size());
+	}
+}
+
+/**
+ * Split a packed value into its first count columns: fields[i] views into value, present[i] is false for NULL.
+ * Returns false if the value isn't a well-formed packed row.
+ */
+inline bool unpack_row(std::string_view value, size_t count, std::string_view *fields, bool *present) {
+	size_t pos = 0;
+	uint64_t stored_count;
+	if (!read_varint(value, pos, stored_count)) {
+		return false;
+	}
+	// Checked before rounding up, which wraps for a corrupt count near UINT64_MAX
+	if (stored_count > (value.size() - pos) * 8) {
+		return false;
+	}
+	auto bitmap_size = (stored_count + 7) / 8;
+	auto bitmap = value.data() + pos;
+	pos += bitmap_size;
+	for (size_t i = 0; i < count; ++i) {
+		present[i] = i < stored_count && !(static_cast<uint8_t>(bitmap[i / 8]) & (1 << (i % 8)));
+		if (!present[i]) {
+			continue;
+		}
+		uint64_t length;
+		if (!read_varint(value, pos, length) || length > value.size() - pos) {
+			return false;
+		}
+		fields[i] = value.substr(pos, length);
+		pos += length;
+	}
+	return true;
+}
+
+} // namespace level_pivot
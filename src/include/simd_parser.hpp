@@ -5,6 +5,7 @@
 #include <optional>
 #include <cstdint>
 #include <cstring>
+#include <utility>
 
 #if defined(__x86_64__) || defined(_M_X64)
 #define LEVEL_PIVOT_X86_64 1
@@ -32,6 +33,7 @@ namespace detail {
 struct CpuFeatures {
 	bool has_sse2 = false;
 	bool has_avx2 = false;
+	bool has_avx512bw = false;
 	bool has_neon = false;
 
 	static const CpuFeatures &get() {
@@ -48,19 +50,29 @@ private:
 		__cpuid(cpuInfo, 0);
 		int nIds = cpuInfo[0];
 
+		// Register state the OS saves on context switches. _xgetbv faults unless OSXSAVE is set.
+		unsigned long long xcr0 = 0;
 		if (nIds >= 1) {
 			__cpuid(cpuInfo, 1);
 			f.has_sse2 = (cpuInfo[3] & (1 << 26)) != 0;
+			if ((cpuInfo[2] & (1 << 27)) != 0) {
+				xcr0 = _xgetbv(0);
+			}
 		}
 		if (nIds >= 7) {
 			__cpuidex(cpuInfo, 7, 0);
-			f.has_avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+			// AVX2 needs the YMM state saved, AVX-512BW also the opmask and ZMM state
+			bool os_ymm = (xcr0 & 0x6) == 0x6;
+			bool os_zmm = (xcr0 & 0xE6) == 0xE6;
+			f.has_avx2 = os_ymm && (cpuInfo[1] & (1 << 5)) != 0;
+			f.has_avx512bw = os_zmm && (cpuInfo[1] & (1 << 30)) != 0;
 		}
 #else
 		// GCC/Clang
 		__builtin_cpu_init();
 		f.has_sse2 = __builtin_cpu_supports("sse2");
 		f.has_avx2 = __builtin_cpu_supports("avx2");
+		f.has_avx512bw = __builtin_cpu_supports("avx512bw");
 #endif
 #endif
 #if defined(LEVEL_PIVOT_AARCH64)
@@ -95,9 +107,41 @@ inline void find_delimiters_scalar(const char *data, size_t len, size_t start, c
 	}
 }
 
+// The vector kernels compare up to the first MAX_VECTOR_DELIM bytes of the delimiter at once: byte k is
+// compared against the block loaded at offset k, and the lane masks are ANDed. Delimiters of up to that length
+// need no memcmp; longer ones only compare their remaining bytes.
+static constexpr size_t MAX_VECTOR_DELIM = 4;
+
+inline bool delimiter_tail_matches(const char *data, size_t pos, const char *delim, size_t delim_len) {
+	return delim_len <= MAX_VECTOR_DELIM ||
+	       memcmp(data + pos + MAX_VECTOR_DELIM, delim + MAX_VECTOR_DELIM, delim_len - MAX_VECTOR_DELIM) == 0;
+}
+
+// Scalar search of [i, len) once the remaining bytes no longer fill a vector block
+inline void find_delimiters_tail(const char *data, size_t len, size_t i, const char *delim, size_t delim_len,
+                                 size_t *positions, size_t &count, size_t max_count, size_t min_next_pos) {
+	while (i + delim_len <= len && count < max_count) {
+		if (i >= min_next_pos && data[i] == delim[0] && memcmp(data + i, delim, delim_len) == 0) {
+			positions[count++] = i;
+			min_next_pos = i + delim_len;
+			i += delim_len;
+		} else {
+			++i;
+		}
+	}
+}
+
 #if defined(LEVEL_PIVOT_X86_64)
 
 // SSE2 implementation
+#if defined(_MSC_VER)
+inline __m128i load_sse2(const char *p) {
+#else
+__attribute__((target("sse2"))) inline __m128i load_sse2(const char *p) {
+#endif
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
 #if defined(_MSC_VER)
 inline void find_delimiters_sse2(
 #else
@@ -105,47 +149,60 @@ __attribute__((target("sse2"))) inline void find_delimiters_sse2(
 #endif
     const char *data, size_t len, size_t start, const char *delim, size_t delim_len, size_t *positions, size_t &count,
     size_t max_count) {
+	size_t vec_len = delim_len < MAX_VECTOR_DELIM ? delim_len : MAX_VECTOR_DELIM;
 	__m128i vd0 = _mm_set1_epi8(delim[0]);
+	__m128i vd1 = _mm_set1_epi8(vec_len > 1 ? delim[1] : 0);
+	__m128i vd2 = _mm_set1_epi8(vec_len > 2 ? delim[2] : 0);
+	__m128i vd3 = _mm_set1_epi8(vec_len > 3 ? delim[3] : 0);
 	size_t i = start;
 	count = 0;
 	size_t min_next_pos = start;
 
-	while (i + 16 <= len && count < max_count) {
-		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
-		__m128i eq0 = _mm_cmpeq_epi8(chunk, vd0);
-		uint32_t mask0 = static_cast<uint32_t>(_mm_movemask_epi8(eq0));
+	// The shifted loads read up to vec_len - 1 bytes past the block
+	while (i + 16 + vec_len - 1 <= len && count < max_count) {
+		const char *block = data + i;
+		__m128i eq = _mm_cmpeq_epi8(load_sse2(block), vd0);
+		if (vec_len > 1) {
+			eq = _mm_and_si128(eq, _mm_cmpeq_epi8(load_sse2(block + 1), vd1));
+		}
+		if (vec_len > 2) {
+			eq = _mm_and_si128(eq, _mm_cmpeq_epi8(load_sse2(block + 2), vd2));
+		}
+		if (vec_len > 3) {
+			eq = _mm_and_si128(eq, _mm_cmpeq_epi8(load_sse2(block + 3), vd3));
+		}
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
 
-		while (mask0 && count < max_count) {
+		while (mask && count < max_count) {
 #if defined(_MSC_VER)
 			unsigned long bit_pos;
-			_BitScanForward(&bit_pos, mask0);
+			_BitScanForward(&bit_pos, mask);
 #else
-			uint32_t bit_pos = static_cast<uint32_t>(__builtin_ctz(mask0));
+			uint32_t bit_pos = static_cast<uint32_t>(__builtin_ctz(mask));
 #endif
 			size_t pos = i + bit_pos;
 
-			if (pos >= min_next_pos && pos + delim_len <= len && memcmp(data + pos, delim, delim_len) == 0) {
+			if (pos >= min_next_pos && pos + delim_len <= len && delimiter_tail_matches(data, pos, delim, delim_len)) {
 				positions[count++] = pos;
 				min_next_pos = pos + delim_len;
 			}
-			mask0 &= mask0 - 1;
+			mask &= mask - 1;
 		}
 		i += 16;
 	}
 
-	// Handle tail
-	while (i + delim_len <= len && count < max_count) {
-		if (i >= min_next_pos && data[i] == delim[0] && memcmp(data + i, delim, delim_len) == 0) {
-			positions[count++] = i;
-			min_next_pos = i + delim_len;
-			i += delim_len;
-		} else {
-			++i;
-		}
-	}
+	find_delimiters_tail(data, len, i, delim, delim_len, positions, count, max_count, min_next_pos);
 }
 
 // AVX2 implementation
+#if defined(_MSC_VER)
+inline __m256i load_avx2(const char *p) {
+#else
+__attribute__((target("avx2"))) inline __m256i load_avx2(const char *p) {
+#endif
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
 #if defined(_MSC_VER)
 inline void find_delimiters_avx2(
 #else
@@ -153,43 +210,112 @@ __attribute__((target("avx2"))) inline void find_delimiters_avx2(
 #endif
     const char *data, size_t len, size_t start, const char *delim, size_t delim_len, size_t *positions, size_t &count,
     size_t max_count) {
+	size_t vec_len = delim_len < MAX_VECTOR_DELIM ? delim_len : MAX_VECTOR_DELIM;
 	__m256i vd0 = _mm256_set1_epi8(delim[0]);
+	__m256i vd1 = _mm256_set1_epi8(vec_len > 1 ? delim[1] : 0);
+	__m256i vd2 = _mm256_set1_epi8(vec_len > 2 ? delim[2] : 0);
+	__m256i vd3 = _mm256_set1_epi8(vec_len > 3 ? delim[3] : 0);
 	size_t i = start;
 	count = 0;
 	size_t min_next_pos = start;
 
-	while (i + 32 <= len && count < max_count) {
-		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
-		__m256i eq0 = _mm256_cmpeq_epi8(chunk, vd0);
-		uint32_t mask0 = static_cast<uint32_t>(_mm256_movemask_epi8(eq0));
+	while (i + 32 + vec_len - 1 <= len && count < max_count) {
+		const char *block = data + i;
+		__m256i eq = _mm256_cmpeq_epi8(load_avx2(block), vd0);
+		if (vec_len > 1) {
+			eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(load_avx2(block + 1), vd1));
+		}
+		if (vec_len > 2) {
+			eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(load_avx2(block + 2), vd2));
+		}
+		if (vec_len > 3) {
+			eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(load_avx2(block + 3), vd3));
+		}
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
 
-		while (mask0 && count < max_count) {
+		while (mask && count < max_count) {
 #if defined(_MSC_VER)
 			unsigned long bit_pos;
-			_BitScanForward(&bit_pos, mask0);
+			_BitScanForward(&bit_pos, mask);
 #else
-			uint32_t bit_pos = static_cast<uint32_t>(__builtin_ctz(mask0));
+			uint32_t bit_pos = static_cast<uint32_t>(__builtin_ctz(mask));
 #endif
 			size_t pos = i + bit_pos;
 
-			if (pos >= min_next_pos && pos + delim_len <= len && memcmp(data + pos, delim, delim_len) == 0) {
+			if (pos >= min_next_pos && pos + delim_len <= len && delimiter_tail_matches(data, pos, delim, delim_len)) {
 				positions[count++] = pos;
 				min_next_pos = pos + delim_len;
 			}
-			mask0 &= mask0 - 1;
+			mask &= mask - 1;
 		}
 		i += 32;
 	}
 
-	// Handle tail with scalar
+	find_delimiters_tail(data, len, i, delim, delim_len, positions, count, max_count, min_next_pos);
+}
+
+// AVX-512BW implementation. Masked loads cover the end of the key too, so short keys (the common case) are
+// searched in a single 64-byte step with no scalar tail.
+#if defined(_MSC_VER)
+inline __m512i load_avx512(
+#else
+__attribute__((target("avx512bw"))) inline __m512i load_avx512(
+#endif
+    const char *data, size_t offset, size_t len) {
+	if (offset + 64 <= len) {
+		return _mm512_loadu_si512(data + offset);
+	}
+	// Lanes past the end read as zero and never fault
+	return _mm512_maskz_loadu_epi8((static_cast<uint64_t>(1) << (len - offset)) - 1, data + offset);
+}
+
+#if defined(_MSC_VER)
+inline void find_delimiters_avx512(
+#else
+__attribute__((target("avx512bw"))) inline void find_delimiters_avx512(
+#endif
+    const char *data, size_t len, size_t start, const char *delim, size_t delim_len, size_t *positions, size_t &count,
+    size_t max_count) {
+	size_t vec_len = delim_len < MAX_VECTOR_DELIM ? delim_len : MAX_VECTOR_DELIM;
+	__m512i vd0 = _mm512_set1_epi8(delim[0]);
+	__m512i vd1 = _mm512_set1_epi8(vec_len > 1 ? delim[1] : 0);
+	__m512i vd2 = _mm512_set1_epi8(vec_len > 2 ? delim[2] : 0);
+	__m512i vd3 = _mm512_set1_epi8(vec_len > 3 ? delim[3] : 0);
+	size_t i = start;
+	count = 0;
+	size_t min_next_pos = start;
+
 	while (i + delim_len <= len && count < max_count) {
-		if (i >= min_next_pos && data[i] == delim[0] && memcmp(data + i, delim, delim_len) == 0) {
-			positions[count++] = i;
-			min_next_pos = i + delim_len;
-			i += delim_len;
-		} else {
-			++i;
+		// Only positions where the whole delimiter fits are candidates, so zeroed lanes never produce a match
+		size_t candidates = len - delim_len - i + 1;
+		uint64_t mask = candidates >= 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << candidates) - 1;
+		mask &= _mm512_cmpeq_epi8_mask(load_avx512(data, i, len), vd0);
+		if (vec_len > 1) {
+			mask &= _mm512_cmpeq_epi8_mask(load_avx512(data, i + 1, len), vd1);
+		}
+		if (vec_len > 2) {
+			mask &= _mm512_cmpeq_epi8_mask(load_avx512(data, i + 2, len), vd2);
+		}
+		if (vec_len > 3) {
+			mask &= _mm512_cmpeq_epi8_mask(load_avx512(data, i + 3, len), vd3);
 		}
+
+		while (mask && count < max_count) {
+#if defined(_MSC_VER)
+			unsigned long bit_pos;
+			_BitScanForward64(&bit_pos, mask);
+#else
+			uint32_t bit_pos = static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+			size_t pos = i + bit_pos;
+
+			if (pos >= min_next_pos && delimiter_tail_matches(data, pos, delim, delim_len)) {
+				positions[count++] = pos;
+				min_next_pos = pos + delim_len;
+			}
+			mask &= mask - 1;
+		}
+		i += 64;
 	}
 }
 
@@ -218,21 +344,27 @@ static inline uint16_t neon_movemask_u8(uint8x16_t v) {
 // NEON implementation (16 bytes per iteration, same throughput as SSE2)
 inline void find_delimiters_neon(const char *data, size_t len, size_t start, const char *delim, size_t delim_len,
                                  size_t *positions, size_t &count, size_t max_count) {
-	uint8x16_t vd0 = vdupq_n_u8(static_cast<uint8_t>(delim[0]));
+	size_t vec_len = delim_len < MAX_VECTOR_DELIM ? delim_len : MAX_VECTOR_DELIM;
+	uint8x16_t vd[MAX_VECTOR_DELIM];
+	for (size_t k = 0; k < MAX_VECTOR_DELIM; ++k) {
+		vd[k] = vdupq_n_u8(k < vec_len ? static_cast<uint8_t>(delim[k]) : 0);
+	}
 	size_t i = start;
 	count = 0;
 	size_t min_next_pos = start;
 
-	while (i + 16 <= len && count < max_count) {
-		uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(data + i));
-		uint8x16_t eq0 = vceqq_u8(chunk, vd0);
-		uint32_t mask0 = neon_movemask_u8(eq0);
+	while (i + 16 + vec_len - 1 <= len && count < max_count) {
+		uint8x16_t eq = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(data + i)), vd[0]);
+		for (size_t k = 1; k < vec_len; ++k) {
+			eq = vandq_u8(eq, vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(data + i + k)), vd[k]));
+		}
+		uint32_t mask0 = neon_movemask_u8(eq);
 
 		while (mask0 && count < max_count) {
 			uint32_t bit_pos = static_cast<uint32_t>(__builtin_ctz(mask0));
 			size_t pos = i + bit_pos;
 
-			if (pos >= min_next_pos && pos + delim_len <= len && memcmp(data + pos, delim, delim_len) == 0) {
+			if (pos >= min_next_pos && pos + delim_len <= len && delimiter_tail_matches(data, pos, delim, delim_len)) {
 				positions[count++] = pos;
 				min_next_pos = pos + delim_len;
 			}
@@ -241,16 +373,7 @@ inline void find_delimiters_neon(const char *data, size_t len, size_t start, con
 		i += 16;
 	}
 
-	// Handle tail
-	while (i + delim_len <= len && count < max_count) {
-		if (i >= min_next_pos && data[i] == delim[0] && memcmp(data + i, delim, delim_len) == 0) {
-			positions[count++] = i;
-			min_next_pos = i + delim_len;
-			i += delim_len;
-		} else {
-			++i;
-		}
-	}
+	find_delimiters_tail(data, len, i, delim, delim_len, positions, count, max_count, min_next_pos);
 }
 
 #endif // LEVEL_PIVOT_AARCH64
@@ -263,6 +386,9 @@ using FindDelimitersFn = void (*)(const char *data, size_t len, size_t start, co
 inline FindDelimitersFn select_find_delimiters() {
 #if defined(LEVEL_PIVOT_X86_64)
 	const auto &cpu = CpuFeatures::get();
+	if (cpu.has_avx512bw) {
+		return find_delimiters_avx512;
+	}
 	if (cpu.has_avx2) {
 		return find_delimiters_avx2;
 	}
@@ -293,7 +419,7 @@ inline FindDelimitersFn get_find_delimiters() {
  * This is a specialized fast-path for common patterns like:
  *   prefix##capture1##capture2##...##attr
  *
- * Uses runtime CPU detection to select SSE2/AVX2/scalar implementation.
+ * Uses runtime CPU detection to select AVX-512BW/AVX2/SSE2/NEON/scalar implementation.
  * Detection happens once at startup; subsequent calls have zero overhead.
  */
 class SimdKeyParser {
@@ -329,7 +455,7 @@ public:
 		}
 
 		size_t search_start = prefix_.size();
-		size_t delim_stack[MAX_KEY_CAPTURES + 1];
+		size_t delim_stack[MAX_KEY_CAPTURES + 2]; // one past num_delimiters_ to detect extra delimiters
 		size_t delim_count = 0;
 
 		find_delimiters_(key.data(), key.size(), search_start, delimiter_.data(), delimiter_.size(), delim_stack,
@@ -362,12 +488,28 @@ public:
 		return true;
 	}
 
+	/**
+	 * Locate only the attr of a key whose first identity_len bytes (prefix, captures and the delimiter before
+	 * the attr) equal those of a key parse_fast accepted. Delimiters are matched left to right without overlap,
+	 * so those bytes split the same way here and the attr is valid iff it holds no further delimiter.
+	 */
+	bool parse_attr(std::string_view key, size_t identity_len, std::string_view &attr) const {
+		if (identity_len >= key.size()) {
+			return false;
+		}
+		attr = key.substr(identity_len);
+		return attr.find(delimiter_) == std::string_view::npos;
+	}
+
 	/**
 	 * Get the name of the SIMD implementation being used
 	 */
 	static const char *implementation_name() {
 #if defined(LEVEL_PIVOT_X86_64)
 		const auto &cpu = detail::CpuFeatures::get();
+		if (cpu.has_avx512bw) {
+			return "AVX-512BW";
+		}
 		if (cpu.has_avx2) {
 			return "AVX2";
 		}
@@ -384,7 +526,7 @@ public:
 		return "scalar";
 	}
 
-private:
+protected:
 	std::string_view prefix_;
 	std::string_view delimiter_;
 	size_t num_captures_;
@@ -392,4 +534,58 @@ private:
 	detail::FindDelimitersFn find_delimiters_;
 };
 
+/**
+ * SimdKeyParser specialized for N captures (the common 1-6)
+ *
+ * Delimiter count checks and capture extraction are unrolled at compile time instead of looping over
+ * num_captures_. Loops over keys instantiated for this type (see KeyParser::visit) call parse_fast directly.
+ */
+template <size_t N>
+class SimdKeyParserN : public SimdKeyParser {
+public:
+	SimdKeyParserN(std::string_view prefix, std::string_view delimiter) : SimdKeyParser(prefix, delimiter, N) {
+	}
+
+	bool parse_fast(std::string_view key, std::string_view *captures, std::string_view &attr) const {
+		const size_t delim_len = delimiter_.size();
+		if (key.size() < prefix_.size() + delim_len * (N + 1)) {
+			return false;
+		}
+		if (!prefix_.empty() && memcmp(key.data(), prefix_.data(), prefix_.size()) != 0) {
+			return false;
+		}
+
+		// N + 1 delimiters, plus room for one more to reject keys that have it
+		size_t delims[N + 2];
+		size_t delim_count = 0;
+		find_delimiters_(key.data(), key.size(), prefix_.size(), delimiter_.data(), delim_len, delims, delim_count,
+		                 N + 2);
+		if (delim_count != N + 1 || delims[0] != prefix_.size()) {
+			return false;
+		}
+		if (!extract_captures(key, delims, delim_len, captures, std::make_index_sequence<N>())) {
+			return false;
+		}
+
+		size_t attr_pos = delims[N] + delim_len;
+		if (attr_pos >= key.size()) {
+			return false;
+		}
+		attr = key.substr(attr_pos);
+		return true;
+	}
+
+private:
+	// Capture I lies between delimiters I and I + 1 and must not be empty
+	template <size_t... I>
+	static bool extract_captures(std::string_view key, const size_t *delims, size_t delim_len,
+	                             std::string_view *captures, std::index_sequence<I...>) {
+		if (!((delims[I + 1] > delims[I] + delim_len) && ...)) {
+			return false;
+		}
+		((captures[I] = key.substr(delims[I] + delim_len, delims[I + 1] - delims[I] - delim_len)), ...);
+		return true;
+	}
+};
+
 } // namespace level_pivot
@@ -18,6 +18,8 @@ namespace duckdb {
 TableFunction GetCreateTableFunction();
 TableFunction GetDropTableFunction();
 TableFunction GetDirtyTablesFunction();
+TableFunction GetAnalyzeFunction();
+TableFunctionSet GetLookupFunctions();
 
 static unique_ptr<Catalog> LevelPivotAttach(optional_ptr<StorageExtensionInfo> storage_info, ClientContext &context,
                                             AttachedDatabase &db, const string &name, AttachInfo &info,
@@ -44,6 +46,24 @@ static unique_ptr<Catalog> LevelPivotAttach(optional_ptr<StorageExtensionInfo> s
 			conn_opts.block_cache_size = kv.second.GetValue<int64_t>();
 		} else if (key == "write_buffer_size") {
 			conn_opts.write_buffer_size = kv.second.GetValue<int64_t>();
+		} else if (key == "bloom_filter_bits") {
+			conn_opts.bloom_filter_bits = kv.second.GetValue<int32_t>();
+		} else if (key == "durability") {
+			auto mode = StringUtil::Lower(kv.second.ToString());
+			if (mode == "none") {
+				conn_opts.durability = level_pivot::Durability::NONE;
+			} else if (mode == "batch" || mode == "always") {
+				// 'always' is an alias: LevelDB groups concurrent synced writes itself, so syncing every write already
+				// batches them
+				conn_opts.durability = level_pivot::Durability::SYNC;
+			} else {
+				throw InvalidInputException(
+				    "Invalid durability '%s'. Must be 'none', or 'batch'/'always' (both sync every write).", mode);
+			}
+		} else if (key == "async_writes") {
+			conn_opts.async_writes = kv.second.GetValue<bool>();
+		} else if (key == "max_transaction_size") {
+			conn_opts.max_transaction_size = kv.second.GetValue<int64_t>();
 		}
 	}
 
@@ -94,6 +114,8 @@ static void LoadInternal(ExtensionLoader &loader) {
 	loader.RegisterFunction(GetCreateTableFunction());
 	loader.RegisterFunction(GetDropTableFunction());
 	loader.RegisterFunction(GetDirtyTablesFunction());
+	loader.RegisterFunction(GetAnalyzeFunction());
+	loader.RegisterFunction(GetLookupFunctions());
 }
 
 void LevelPivotExtension::Load(ExtensionLoader &loader) {
@@ -1,62 +1,261 @@
 #include "level_pivot_storage.hpp"
 #include <leveldb/db.h>
 #include <leveldb/cache.h>
+#include <leveldb/filter_policy.h>
 #include <leveldb/options.h>
 #include <leveldb/iterator.h>
 #include <leveldb/write_batch.h>
+#include <vector>
 
 namespace level_pivot {
 
+static std::string_view ToView(const leveldb::Slice &slice) {
+	return std::string_view(slice.data(), slice.size());
+}
+
+// --- LevelDBWriteSet ---
+
+static size_t ValueSize(const std::optional<std::string> &value) {
+	return value ? value->size() : 0;
+}
+
+void LevelDBWriteSet::put(std::string_view key, std::string_view value) {
+	auto it = entries_.lower_bound(key);
+	if (it != entries_.end() && it->first == key) {
+		bytes_ -= ValueSize(it->second);
+		it->second.emplace(value);
+	} else {
+		entries_.emplace_hint(it, std::string(key), std::string(value));
+		bytes_ += key.size();
+	}
+	bytes_ += value.size();
+}
+
+void LevelDBWriteSet::del(std::string_view key) {
+	auto it = entries_.lower_bound(key);
+	if (it != entries_.end() && it->first == key) {
+		bytes_ -= ValueSize(it->second);
+		it->second.reset();
+	} else {
+		entries_.emplace_hint(it, std::string(key), std::nullopt);
+		bytes_ += key.size();
+	}
+}
+
+void LevelDBWriteSet::merge(LevelDBWriteSet &&other) {
+	if (entries_.empty()) {
+		entries_.swap(other.entries_);
+		std::swap(bytes_, other.bytes_);
+		return;
+	}
+	// Moves the nodes of keys we don't have; the ones left in other are keys written by both
+	bytes_ += other.bytes_;
+	entries_.merge(other.entries_);
+	for (auto &entry : other.entries_) {
+		auto &value = entries_.find(entry.first)->second;
+		bytes_ -= entry.first.size() + ValueSize(value);
+		value = std::move(entry.second);
+	}
+	other.clear();
+}
+
+void LevelDBWriteSet::commit(LevelDBConnection &connection) {
+	if (entries_.empty()) {
+		return;
+	}
+	auto batch = connection.create_batch();
+	for (auto &entry : entries_) {
+		if (entry.second) {
+			batch.put(entry.first, *entry.second);
+		} else {
+			batch.del(entry.first);
+		}
+	}
+	batch.commit();
+	clear();
+}
+
+// --- LevelDBSnapshot ---
+
+LevelDBSnapshot::LevelDBSnapshot(leveldb::DB *db) : db_(db), snapshot_(db->GetSnapshot()) {
+}
+
+LevelDBSnapshot::~LevelDBSnapshot() {
+	db_->ReleaseSnapshot(snapshot_);
+}
+
 // --- LevelDBIterator ---
 
-LevelDBIterator::LevelDBIterator(leveldb::DB *db) {
+LevelDBIterator::LevelDBIterator(leveldb::DB *db, const LevelDBWriteSet *overlay, const LevelDBSnapshot *snapshot)
+    : overlay_(overlay) {
 	leveldb::ReadOptions options;
 	options.fill_cache = true;
+	options.snapshot = snapshot ? snapshot->get() : nullptr;
 	iter_.reset(db->NewIterator(options));
+	if (overlay_) {
+		pos_ = overlay_->entries().end();
+	}
 }
 
 LevelDBIterator::~LevelDBIterator() = default;
 
-LevelDBIterator::LevelDBIterator(LevelDBIterator &&other) noexcept : iter_(std::move(other.iter_)) {
+LevelDBIterator::LevelDBIterator(LevelDBIterator &&other) noexcept
+    : iter_(std::move(other.iter_)), overlay_(other.overlay_), pos_(other.pos_), from_overlay_(other.from_overlay_),
+      valid_(other.valid_) {
 }
 
 LevelDBIterator &LevelDBIterator::operator=(LevelDBIterator &&other) noexcept {
 	iter_ = std::move(other.iter_);
+	overlay_ = other.overlay_;
+	pos_ = other.pos_;
+	from_overlay_ = other.from_overlay_;
+	valid_ = other.valid_;
 	return *this;
 }
 
+// Pick the smaller of the database and overlay keys, skipping deleted keys and database keys the overlay replaces
+void LevelDBIterator::settle() {
+	auto end = overlay_->entries().end();
+	while (true) {
+		bool db_valid = iter_->Valid();
+		if (pos_ == end) {
+			from_overlay_ = false;
+			valid_ = db_valid;
+			return;
+		}
+		if (db_valid) {
+			auto cmp = std::string_view(pos_->first).compare(ToView(iter_->key()));
+			if (cmp > 0) {
+				from_overlay_ = false;
+				valid_ = true;
+				return;
+			}
+			if (cmp == 0) {
+				iter_->Next();
+			}
+		}
+		if (pos_->second) {
+			from_overlay_ = true;
+			valid_ = true;
+			return;
+		}
+		++pos_;
+	}
+}
+
+// Position on the last visible key below limit (nullptr = no limit). Backward steps are rare (range partitioning),
+// so this finds the key and then seeks to it forward.
+void LevelDBIterator::seek_before(const std::string *limit) {
+	auto &entries = overlay_->entries();
+	std::string bound = limit ? *limit : std::string();
+	bool bounded = limit != nullptr;
+	while (true) {
+		if (!bounded) {
+			iter_->SeekToLast();
+		} else {
+			iter_->Seek(bound);
+			if (iter_->Valid()) {
+				iter_->Prev();
+			} else {
+				iter_->SeekToLast();
+			}
+		}
+		auto it = bounded ? entries.lower_bound(bound) : entries.end();
+		bool has_entry = it != entries.begin();
+		if (has_entry) {
+			--it;
+		}
+		if (!has_entry && !iter_->Valid()) {
+			pos_ = entries.end();
+			valid_ = false;
+			return;
+		}
+		if (has_entry && (!iter_->Valid() || std::string_view(it->first) >= ToView(iter_->key()))) {
+			if (!it->second) {
+				// Deleted, along with any database key it replaces; keep looking below it
+				bound = it->first;
+				bounded = true;
+				continue;
+			}
+			bound = it->first;
+		} else {
+			bound = iter_->key().ToString();
+		}
+		seek(bound);
+		return;
+	}
+}
+
 void LevelDBIterator::seek(std::string_view key) {
 	iter_->Seek(leveldb::Slice(key.data(), key.size()));
+	if (overlay_) {
+		pos_ = overlay_->entries().lower_bound(key);
+		settle();
+	}
 }
 
 void LevelDBIterator::seek_to_first() {
 	iter_->SeekToFirst();
+	if (overlay_) {
+		pos_ = overlay_->entries().begin();
+		settle();
+	}
+}
+
+void LevelDBIterator::seek_to_last() {
+	if (overlay_) {
+		seek_before(nullptr);
+	} else {
+		iter_->SeekToLast();
+	}
 }
 
 void LevelDBIterator::next() {
-	iter_->Next();
+	if (!overlay_) {
+		iter_->Next();
+		return;
+	}
+	if (from_overlay_) {
+		++pos_;
+	} else {
+		iter_->Next();
+	}
+	settle();
+}
+
+void LevelDBIterator::prev() {
+	if (overlay_) {
+		auto current = key();
+		seek_before(&current);
+	} else {
+		iter_->Prev();
+	}
 }
 
 bool LevelDBIterator::valid() const {
-	return iter_->Valid();
+	return overlay_ ? valid_ : iter_->Valid();
 }
 
 std::string LevelDBIterator::key() const {
-	return iter_->key().ToString();
+	return std::string(key_view());
 }
 
 std::string LevelDBIterator::value() const {
-	return iter_->value().ToString();
+	return std::string(value_view());
 }
 
 std::string_view LevelDBIterator::key_view() const {
-	auto s = iter_->key();
-	return std::string_view(s.data(), s.size());
+	if (overlay_ && from_overlay_) {
+		return pos_->first;
+	}
+	return ToView(iter_->key());
 }
 
 std::string_view LevelDBIterator::value_view() const {
-	auto s = iter_->value();
-	return std::string_view(s.data(), s.size());
+	if (overlay_ && from_overlay_) {
+		return *pos_->second;
+	}
+	return ToView(iter_->value());
 }
 
 // --- LevelDBWriteBatch ---
@@ -98,11 +297,23 @@ LevelDBWriteBatch &LevelDBWriteBatch::operator=(LevelDBWriteBatch &&other) noexc
 void LevelDBWriteBatch::put(std::string_view key, std::string_view value) {
 	batch_->Put(leveldb::Slice(key.data(), key.size()), leveldb::Slice(value.data(), value.size()));
 	++pending_count_;
+	committed_ = false;
 }
 
 void LevelDBWriteBatch::del(std::string_view key) {
 	batch_->Delete(leveldb::Slice(key.data(), key.size()));
 	++pending_count_;
+	committed_ = false;
+}
+
+void LevelDBWriteBatch::append(LevelDBWriteBatch &&other) {
+	if (other.pending_count_ == 0) {
+		return;
+	}
+	batch_->Append(*other.batch_);
+	pending_count_ += other.pending_count_;
+	committed_ = false;
+	other.discard();
 }
 
 void LevelDBWriteBatch::commit() {
@@ -110,17 +321,33 @@ void LevelDBWriteBatch::commit() {
 		return;
 	}
 	if (connection_ && batch_ && pending_count_ > 0) {
-		leveldb::WriteOptions options;
-		options.sync = false;
-		leveldb::Status status = connection_->raw()->Write(options, batch_.get());
+		if (connection_->async_writes_) {
+			auto pending = commit_async();
+			connection_->wait_for_write(*pending);
+			return;
+		}
+		leveldb::Status status = connection_->write(*batch_);
 		if (!status.ok()) {
 			throw LevelDBError("WriteBatch commit failed: " + status.ToString());
 		}
+		batch_->Clear();
 	}
 	committed_ = true;
 	pending_count_ = 0;
 }
 
+std::shared_ptr<LevelDBPendingWrite> LevelDBWriteBatch::commit_async() {
+	if (!connection_->async_writes_ || pending_count_ == 0) {
+		commit();
+		return nullptr;
+	}
+	auto batch = std::move(batch_);
+	batch_ = std::make_unique<leveldb::WriteBatch>();
+	committed_ = true;
+	pending_count_ = 0;
+	return connection_->enqueue_write(std::move(batch));
+}
+
 void LevelDBWriteBatch::discard() {
 	if (batch_) {
 		batch_->Clear();
@@ -137,30 +364,68 @@ bool LevelDBWriteBatch::has_pending() const {
 	return pending_count_ > 0;
 }
 
+size_t LevelDBWriteBatch::bytes() const {
+	return batch_ ? batch_->ApproximateSize() : 0;
+}
+
 // --- LevelDBConnection ---
 
 LevelDBConnection::LevelDBConnection(const ConnectionOptions &options)
-    : path_(options.db_path), read_only_(options.read_only) {
+    : path_(options.db_path), read_only_(options.read_only), durability_(options.durability),
+      max_transaction_size_(options.max_transaction_size), async_writes_(options.async_writes && !read_only_) {
 	leveldb::Options db_options;
 	db_options.create_if_missing = options.create_if_missing;
 	db_options.write_buffer_size = options.write_buffer_size;
 	if (options.block_cache_size > 0) {
-		db_options.block_cache = leveldb::NewLRUCache(options.block_cache_size);
+		block_cache_ = leveldb::NewLRUCache(options.block_cache_size);
+		db_options.block_cache = block_cache_;
+	}
+	// Bloom filters let Get() skip SST files that can't hold the key, so point lookups that miss stay cheap
+	if (options.bloom_filter_bits > 0) {
+		filter_policy_ = leveldb::NewBloomFilterPolicy(options.bloom_filter_bits);
+		db_options.filter_policy = filter_policy_;
 	}
 
 	leveldb::Status status = leveldb::DB::Open(db_options, path_, &db_);
 	if (!status.ok()) {
+		delete filter_policy_;
+		delete block_cache_;
 		throw LevelDBError("Failed to open LevelDB at '" + path_ + "': " + status.ToString());
 	}
+	if (async_writes_) {
+		writer_thread_ = std::thread([this]() { run_writer(); });
+	}
 }
 
 LevelDBConnection::~LevelDBConnection() {
+	if (writer_thread_.joinable()) {
+		// The writer finishes the queue before it stops
+		{
+			std::lock_guard<std::mutex> guard(writer_lock_);
+			stopping_ = true;
+		}
+		writer_cv_.notify_one();
+		writer_thread_.join();
+	}
+	// The DB references the cache and filter policy, so it must go first
 	delete db_;
+	delete filter_policy_;
+	delete block_cache_;
 }
 
-std::optional<std::string> LevelDBConnection::get(std::string_view key) {
+std::optional<std::string> LevelDBConnection::get(std::string_view key, const LevelDBWriteSet *overlay,
+                                                  const LevelDBSnapshot *snapshot) {
+	if (overlay) {
+		auto &entries = overlay->entries();
+		auto it = entries.find(key);
+		if (it != entries.end()) {
+			return it->second;
+		}
+	}
+	wait_for_writes();
 	std::string value;
 	leveldb::ReadOptions options;
+	options.snapshot = snapshot ? snapshot->get() : nullptr;
 	leveldb::Slice key_slice(key.data(), key.size());
 	leveldb::Status status = db_->Get(options, key_slice, &value);
 	if (status.IsNotFound()) {
@@ -174,10 +439,10 @@ std::optional<std::string> LevelDBConnection::get(std::string_view key) {
 
 void LevelDBConnection::put(std::string_view key, std::string_view value) {
 	check_write_allowed();
-	leveldb::WriteOptions options;
-	options.sync = false;
-	leveldb::Status status =
-	    db_->Put(options, leveldb::Slice(key.data(), key.size()), leveldb::Slice(value.data(), value.size()));
+	wait_for_writes();
+	leveldb::WriteBatch batch;
+	batch.Put(leveldb::Slice(key.data(), key.size()), leveldb::Slice(value.data(), value.size()));
+	leveldb::Status status = write(batch);
 	if (!status.ok()) {
 		throw LevelDBError("Put failed for key '" + std::string(key) + "': " + status.ToString());
 	}
@@ -185,16 +450,116 @@ void LevelDBConnection::put(std::string_view key, std::string_view value) {
 
 void LevelDBConnection::del(std::string_view key) {
 	check_write_allowed();
-	leveldb::WriteOptions options;
-	options.sync = false;
-	leveldb::Status status = db_->Delete(options, leveldb::Slice(key.data(), key.size()));
+	wait_for_writes();
+	leveldb::WriteBatch batch;
+	batch.Delete(leveldb::Slice(key.data(), key.size()));
+	leveldb::Status status = write(batch);
 	if (!status.ok()) {
 		throw LevelDBError("Delete failed for key '" + std::string(key) + "': " + status.ToString());
 	}
 }
 
-LevelDBIterator LevelDBConnection::iterator() {
-	return LevelDBIterator(db_);
+leveldb::Status LevelDBConnection::write(leveldb::WriteBatch &batch) {
+	leveldb::WriteOptions options;
+	options.sync = durability_ == Durability::SYNC;
+	return db_->Write(options, &batch);
+}
+
+LevelDBIterator LevelDBConnection::iterator(const LevelDBWriteSet *overlay, const LevelDBSnapshot *snapshot) {
+	wait_for_writes();
+	return LevelDBIterator(db_, overlay, snapshot);
+}
+
+std::unique_ptr<LevelDBSnapshot> LevelDBConnection::snapshot() {
+	// Queued commits belong to the state being pinned
+	wait_for_writes();
+	return std::make_unique<LevelDBSnapshot>(db_);
+}
+
+// Bytes of batches that may wait in the async write queue; writers block while it is full
+static constexpr size_t MAX_QUEUED_WRITE_BYTES = static_cast<size_t>(64) << 20;
+
+std::shared_ptr<LevelDBPendingWrite> LevelDBConnection::enqueue_write(std::unique_ptr<leveldb::WriteBatch> batch) {
+	auto pending = std::make_shared<LevelDBPendingWrite>();
+	std::unique_lock<std::mutex> lock(writer_lock_);
+	drained_cv_.wait(lock, [&]() { return write_queue_.empty() || queued_bytes_ < MAX_QUEUED_WRITE_BYTES; });
+	queued_bytes_ += batch->ApproximateSize();
+	write_queue_.push_back(QueuedWrite {std::move(batch), pending});
+	++unfinished_writes_;
+	lock.unlock();
+	writer_cv_.notify_one();
+	return pending;
+}
+
+void LevelDBConnection::wait_for_writes() {
+	if (!async_writes_ || unfinished_writes_ == 0) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(writer_lock_);
+	drained_cv_.wait(lock, [&]() { return unfinished_writes_ == 0; });
+}
+
+void LevelDBConnection::wait_for_write(LevelDBPendingWrite &pending) {
+	std::unique_lock<std::mutex> lock(writer_lock_);
+	drained_cv_.wait(lock, [&]() { return pending.done; });
+	if (!pending.error.empty()) {
+		throw LevelDBError("Background write failed: " + pending.error);
+	}
+}
+
+void LevelDBConnection::run_writer() {
+	std::vector<QueuedWrite> writes;
+	std::unique_lock<std::mutex> lock(writer_lock_);
+	while (true) {
+		writer_cv_.wait(lock, [&]() { return !write_queue_.empty() || stopping_; });
+		if (write_queue_.empty()) {
+			return;
+		}
+		// Everything queued goes out as one write. Batches stay whole, so each one remains atomic; if the write
+		// fails, it fails for every batch in it.
+		writes.clear();
+		for (auto &queued : write_queue_) {
+			writes.push_back(std::move(queued));
+		}
+		write_queue_.clear();
+		queued_bytes_ = 0;
+		drained_cv_.notify_all();
+		lock.unlock();
+
+		auto &batch = *writes.front().batch;
+		for (size_t i = 1; i < writes.size(); ++i) {
+			batch.Append(*writes[i].batch);
+		}
+		leveldb::Status status = write(batch);
+
+		lock.lock();
+		for (auto &written : writes) {
+			written.pending->done = true;
+			if (!status.ok()) {
+				written.pending->error = status.ToString();
+			}
+		}
+		unfinished_writes_ -= writes.size();
+		drained_cv_.notify_all();
+	}
+}
+
+uint64_t LevelDBConnection::approximate_size(std::string_view start, std::string_view limit) {
+	std::string limit_key(limit);
+	if (limit_key.empty()) {
+		// GetApproximateSizes needs a concrete upper bound - use the key just past the last one
+		std::unique_ptr<leveldb::Iterator> iter(db_->NewIterator(leveldb::ReadOptions()));
+		iter->SeekToLast();
+		if (!iter->Valid()) {
+			return 0;
+		}
+		limit_key = iter->key().ToString();
+		limit_key.push_back('\0');
+	}
+	leveldb::Range range(leveldb::Slice(start.data(), start.size()), leveldb::Slice(limit_key));
+	uint64_t size = 0;
+	db_->GetApproximateSizes(&range, 1, &size);
+	return size;
 }
 
 LevelDBWriteBatch LevelDBConnection::create_batch() {
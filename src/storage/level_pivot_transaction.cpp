@@ -1,52 +1,99 @@
 #include "level_pivot_transaction.hpp"
+#include "level_pivot_catalog.hpp"
 #include "level_pivot_schema.hpp"
 #include "level_pivot_table_entry.hpp"
 
 namespace duckdb {
 
-// --- LevelPivotTransaction ---
+// --- LevelPivotDirtyTables ---
 
-LevelPivotTransaction::LevelPivotTransaction(TransactionManager &manager, ClientContext &context)
-    : Transaction(manager, context) {
+// True if some key could match patterns with both literal prefixes
+static bool PrefixesOverlap(const string &a, const string &b) {
+	auto len = MinValue(a.size(), b.size());
+	return a.compare(0, len, b, 0, len) == 0;
 }
 
-LevelPivotTransaction::~LevelPivotTransaction() = default;
-
-void LevelPivotTransaction::CheckKeyAgainstTables(std::string_view key, LevelPivotSchemaEntry &schema) {
-	if (all_dirty_) {
-		return;
+void LevelPivotDirtyTables::MarkWriter(LevelPivotTableEntry &table, LevelPivotSchemaEntry &schema,
+                                       vector<reference<LevelPivotTableEntry>> &candidates) {
+	candidates.clear();
+	// A raw table writes any key, as if its pattern had no literal prefix
+	string writer_prefix;
+	if (table.GetTableMode() != LevelPivotTableMode::RAW) {
+		tables_.insert(table.name);
+		writer_prefix = table.GetKeyParser().pattern().literal_prefix();
 	}
-
-	idx_t total_tables = 0;
 	schema.Scan(CatalogType::TABLE_ENTRY, [&](CatalogEntry &entry) {
-		total_tables++;
-		auto &table = entry.Cast<LevelPivotTableEntry>();
-		const auto &table_name = table.name;
-
-		// Skip tables already known dirty
-		if (dirty_tables_.count(table_name)) {
-			return;
+		auto &other = entry.Cast<LevelPivotTableEntry>();
+		if (other.GetTableMode() == LevelPivotTableMode::RAW) {
+			// Raw tables are always affected by any write
+			tables_.insert(other.name);
+		} else if (!tables_.count(other.name) &&
+		           PrefixesOverlap(writer_prefix, other.GetKeyParser().pattern().literal_prefix())) {
+			candidates.push_back(other);
 		}
+	});
+}
 
-		if (table.GetTableMode() == LevelPivotTableMode::RAW) {
-			// Raw tables are always affected by any write
-			dirty_tables_.insert(table_name);
+void LevelPivotDirtyTables::CheckKey(std::string_view key, vector<reference<LevelPivotTableEntry>> &candidates) {
+	for (idx_t i = 0; i < candidates.size();) {
+		auto &parser = candidates[i].get().GetKeyParser();
+		auto &prefix = parser.pattern().literal_prefix();
+		if ((prefix.empty() || key.compare(0, prefix.size(), prefix) == 0) && parser.parse_view(key).has_value()) {
+			tables_.insert(candidates[i].get().name);
+			candidates.erase_at(i);
 		} else {
-			// Pivot table: fast prefix check, then full parse
-			auto &parser = table.GetKeyParser();
-			auto &prefix = parser.pattern().literal_prefix();
-			if (!prefix.empty() && key.compare(0, prefix.size(), prefix) != 0) {
-				return;
-			}
-			if (parser.parse_view(key).has_value()) {
-				dirty_tables_.insert(table_name);
-			}
+			i++;
 		}
-	});
+	}
+}
 
-	if (dirty_tables_.size() >= total_tables) {
-		all_dirty_ = true;
+void LevelPivotDirtyTables::Merge(const LevelPivotDirtyTables &other) {
+	tables_.insert(other.tables_.begin(), other.tables_.end());
+}
+
+// The written tables' stored statistics are deleted in the same batch as the data, so a rollback (or a failed
+// write) keeps them
+template <class WRITES, class APPLY>
+static void CommitWithStatistics(const std::unordered_set<std::string> &tables, LevelPivotCatalog &catalog,
+                                 WRITES &writes, APPLY &&apply) {
+	vector<pair<reference<LevelPivotTableEntry>, idx_t>> written_tables;
+	for (auto &table_name : tables) {
+		auto table = catalog.GetMainSchema().GetTable(table_name);
+		if (table) {
+			written_tables.emplace_back(*table, table->GetStatisticsVersion());
+			writes.del(LevelPivotTableEntry::GetStatisticsKey(table_name));
+		}
 	}
+	apply();
+	// Only now does the stored data change, so only now are the in-memory statistics stale
+	for (auto &written : written_tables) {
+		written.first.get().InvalidateStatistics(written.second);
+	}
+}
+
+void LevelPivotDirtyTables::Commit(LevelPivotCatalog &catalog, level_pivot::LevelDBWriteSet &writes) const {
+	CommitWithStatistics(tables_, catalog, writes, [&]() { writes.commit(*catalog.GetConnection()); });
+}
+
+void LevelPivotDirtyTables::Commit(LevelPivotCatalog &catalog, level_pivot::LevelDBWriteBatch &batch) const {
+	CommitWithStatistics(tables_, catalog, batch, [&]() { batch.commit(); });
+}
+
+// --- LevelPivotTransaction ---
+
+LevelPivotTransaction::LevelPivotTransaction(TransactionManager &manager, ClientContext &context)
+    : Transaction(manager, context) {
+}
+
+LevelPivotTransaction::~LevelPivotTransaction() = default;
+
+LevelPivotTransaction &LevelPivotTransaction::Get(ClientContext &context, Catalog &catalog) {
+	return Transaction::Get(context, catalog).Cast<LevelPivotTransaction>();
+}
+
+void LevelPivotTransaction::MergeDirtyTables(const LevelPivotDirtyTables &dirty) {
+	lock_guard<mutex> l(dirty_lock_);
+	dirty_tables_.Merge(dirty);
 }
 
 // --- LevelPivotTransactionManager ---
@@ -57,28 +104,35 @@ LevelPivotTransactionManager::LevelPivotTransactionManager(AttachedDatabase &db)
 LevelPivotTransactionManager::~LevelPivotTransactionManager() = default;
 
 Transaction &LevelPivotTransactionManager::StartTransaction(ClientContext &context) {
+	auto transaction = make_uniq<LevelPivotTransaction>(*this, context);
+	auto &result = *transaction;
 	lock_guard<mutex> l(transaction_lock);
-	current_transaction = make_uniq<LevelPivotTransaction>(*this, context);
-	return *current_transaction;
+	transactions[result] = std::move(transaction);
+	return result;
 }
 
 ErrorData LevelPivotTransactionManager::CommitTransaction(ClientContext &context, Transaction &transaction) {
+	// Only this connection uses its transaction, so the write runs outside the lock and concurrent commits reach
+	// LevelDB together, where synced ones share an fsync
+	ErrorData error;
+	try {
+		transaction.Cast<LevelPivotTransaction>().Commit(db.GetCatalog().Cast<LevelPivotCatalog>());
+	} catch (std::exception &ex) {
+		error = ErrorData(ex);
+	}
 	lock_guard<mutex> l(transaction_lock);
-	current_transaction.reset();
-	return ErrorData();
+	transactions.erase(transaction);
+	return error;
 }
 
 void LevelPivotTransactionManager::RollbackTransaction(Transaction &transaction) {
 	lock_guard<mutex> l(transaction_lock);
-	current_transaction.reset();
+	transactions.erase(transaction);
 }
 
 void LevelPivotTransactionManager::Checkpoint(ClientContext &context, bool force) {
-}
-
-LevelPivotTransaction *LevelPivotTransactionManager::GetCurrentTransaction() {
-	lock_guard<mutex> l(transaction_lock);
-	return current_transaction.get();
+	// LevelDB persists its own data; a checkpoint only has to wait for queued async writes
+	db.GetCatalog().Cast<LevelPivotCatalog>().GetConnection()->wait_for_writes();
 }
 
 } // namespace duckdb